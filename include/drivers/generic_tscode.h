@@ -7,7 +7,15 @@ extern "C" {
 
 #include "maus_bus.h"
 
+#define TSCODE_ADDRESS 0x69
+
 maus_bus_err_t generic_tscode_tx(uint8_t *data, size_t length);
+
+/**
+ * @brief Vectored TS-Code transmit. The first byte of the first non-empty segment is the
+ * subaddress, everything after it is sent as-is without being copied into a frame buffer.
+ */
+maus_bus_err_t generic_tscode_txv(const maus_bus_segment_t *segments, size_t count);
 maus_bus_err_t generic_tscode_rx(uint8_t *data, size_t *count, size_t max_length);
 
 #ifdef __cplusplus
@@ -0,0 +1,56 @@
+#ifndef __drivers__pca9554_hpp
+#define __drivers__pca9554_hpp
+
+/**
+ * Typed register map for the PCA9554/PCA9554A. See maus_bus_regmap.hpp.
+ *
+ * Setting several pins in one write() costs one read-modify-write of the register, instead of one
+ * per pin.
+ */
+
+#include "drivers/pca9554.h"
+#include "maus_bus_regmap.hpp"
+
+namespace maus_bus {
+namespace pca9554 {
+
+struct chip {
+    static constexpr uint8_t default_address = PCA9554_ADDRESS;
+
+    static constexpr uint8_t subaddress(uint8_t index) {
+        return index;
+    }
+};
+
+namespace input {
+using reg = maus_bus::reg<chip, PCA9554_REG_INPUT, access::read_only>;
+template <uint8_t N>
+inline constexpr field<reg, N, 1, pca9554_gpio_level_t> pin{};
+inline constexpr field<reg, 0, 8> all{};
+} // namespace input
+
+namespace output {
+using reg = maus_bus::reg<chip, PCA9554_REG_OUTPUT>;
+template <uint8_t N>
+inline constexpr field<reg, N, 1, pca9554_gpio_level_t> pin{};
+inline constexpr field<reg, 0, 8> all{};
+} // namespace output
+
+namespace polarity {
+using reg = maus_bus::reg<chip, PCA9554_REG_POLARITY>;
+template <uint8_t N>
+inline constexpr field<reg, N, 1> inverted{};
+inline constexpr field<reg, 0, 8> all{};
+} // namespace polarity
+
+namespace config {
+using reg = maus_bus::reg<chip, PCA9554_REG_CONFIG>;
+template <uint8_t N>
+inline constexpr field<reg, N, 1, pca9554_gpio_mode_t> pin{};
+inline constexpr field<reg, 0, 8> all{};
+} // namespace config
+
+} // namespace pca9554
+} // namespace maus_bus
+
+#endif
@@ -10,7 +10,44 @@ extern "C" {
 #include <stddef.h>
 
 #define SC16_ADDRESS 0x4D
+
+// Override for boards with a different crystal. 3.072MHz tops out at 192000 baud, and can't hit
+// 115200 within SC16_BAUD_MAX_ERROR_PPM; 1.8432MHz or 14.7456MHz can.
+#ifndef SC16_CRYSTAL_FREQ
 #define SC16_CRYSTAL_FREQ 3072000UL
+#endif
+
+#ifndef SC16_DEFAULT_BAUD
+#define SC16_DEFAULT_BAUD 9600
+#endif
+
+// Largest baud rate error accepted by sc16_set_baud_rate, in parts per million.
+#ifndef SC16_BAUD_MAX_ERROR_PPM
+#define SC16_BAUD_MAX_ERROR_PPM 20000
+#endif
+
+// Flow control thresholds, in bytes of RX FIFO. Multiples of 4, up to 60.
+#ifndef SC16_FLOW_HALT_LEVEL
+#define SC16_FLOW_HALT_LEVEL 56
+#endif
+
+#ifndef SC16_FLOW_RESUME_LEVEL
+#define SC16_FLOW_RESUME_LEVEL 16
+#endif
+
+#ifndef SC16_FIFO_TRIGGER_LEVEL
+#define SC16_FIFO_TRIGGER_LEVEL 32
+#endif
+
+#ifndef SC16_TX_POLL_LIMIT
+#define SC16_TX_POLL_LIMIT 1000
+#endif
+
+#define SC16_XON_CHAR 0x11
+#define SC16_XOFF_CHAR 0x13
+
+// Writing this to LCR selects the enhanced register set (EFR, XON/XOFF).
+#define SC16_LCR_ENHANCED 0xBF
 
 #define SC16_REG_RHR        0x00
 #define SC16_REG_THR        0x00
@@ -57,12 +94,72 @@ typedef enum {
     SC16_STOP_2 = 0x1,
 } sc16_stop_bits_t;
 
+typedef enum {
+    SC16_FLOW_NONE = 0x00,
+    SC16_FLOW_RTS = 0x01,      // Deassert RTS when the RX FIFO reaches SC16_FLOW_HALT_LEVEL.
+    SC16_FLOW_CTS = 0x02,      // Hold transmission while CTS is deasserted.
+    SC16_FLOW_XON_XOFF = 0x04, // Software flow control using XON1/XOFF1, both directions.
+} sc16_flow_control_t;
+
+/**
+ * @brief A baud rate as the chip will actually run it.
+ */
+typedef struct {
+    uint16_t divisor;
+    uint8_t prescaler; // 1 or 4, selected by MCR[7].
+    sc16_baud_t actual;
+    uint32_t error_ppm;
+} sc16_baud_config_t;
+
+/**
+ * @brief Finds the divisor and prescaler closest to the requested baud rate. Touches no hardware.
+ *
+ * @param baud
+ * @param config Filled in with the best match, even when that match is rejected.
+ * @return maus_bus_err_t MAUS_BUS_NOT_SUPPORTED if the rate is out of range or the error exceeds
+ * SC16_BAUD_MAX_ERROR_PPM.
+ */
+maus_bus_err_t sc16_calc_baud(sc16_baud_t baud, sc16_baud_config_t *config);
+maus_bus_err_t sc16_apply_baud(const sc16_baud_config_t *config);
+
+/**
+ * @brief Reads back the baud configuration last applied, including its error.
+ */
+void sc16_get_baud_config(sc16_baud_config_t *config);
+
 maus_bus_err_t sc16_set_baud_rate(sc16_baud_t baud);
+
+/**
+ * @brief Configures automatic flow control through EFR, TCR and TLR.
+ *
+ * maus_bus_uart_driver_t has no way to reach this, so call it directly once the serial accessory
+ * is registered. The chip is always at SC16_ADDRESS.
+ *
+ * @param flags Any combination of sc16_flow_control_t.
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t sc16_set_flow_control(uint8_t flags);
+
+/**
+ * @brief maus_bus_uart_driver_t.set_mode implementation.
+ *
+ * @param baud
+ * @param data Data bits, 5 to 8.
+ * @param parity A sc16_parity_t value.
+ * @param stop Stop bits, 1 or 2.
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t sc16_set_mode(uint32_t baud, uint8_t data, uint8_t parity, uint8_t stop);
 maus_bus_err_t sc16_set_format(sc16_data_bits_t data_bits, sc16_parity_t parity, sc16_stop_bits_t stop);
 maus_bus_err_t sc16_enable_fifo(void);
 maus_bus_err_t sc16_disable_fifo(void);
+
+// Like the rest of the driver, these return the first error the bus reported, e.g.
+// MAUS_BUS_UNAVAILABLE while the chip is failing fast. sc16_tx and sc16_txv return
+// MAUS_BUS_TIMEOUT if the TX FIFO stays full for SC16_TX_POLL_LIMIT polls.
 maus_bus_err_t sc16_init(sc16_baud_t baud, sc16_data_bits_t data_bits, sc16_parity_t parity, sc16_stop_bits_t stop);
 maus_bus_err_t sc16_tx(uint8_t *data, size_t length);
+maus_bus_err_t sc16_txv(const maus_bus_segment_t *segments, size_t count);
 maus_bus_err_t sc16_rx(uint8_t *data, size_t *count, size_t max_length);
 
 #ifdef __cplusplus
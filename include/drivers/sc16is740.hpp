@@ -0,0 +1,106 @@
+#ifndef __drivers__sc16is740_hpp
+#define __drivers__sc16is740_hpp
+
+/**
+ * Typed register map for the SC16IS740. See maus_bus_regmap.hpp.
+ *
+ * Only the general register set is described here. DLL/DLH, EFR and the XON/XOFF registers share
+ * subaddresses with it and are selected by writing LCR first, which is left to the caller.
+ */
+
+#include "drivers/sc16is740.h"
+#include "maus_bus_regmap.hpp"
+
+namespace maus_bus {
+namespace sc16is740 {
+
+struct chip {
+    static constexpr uint8_t default_address = SC16_ADDRESS;
+
+    static constexpr uint8_t subaddress(uint8_t index) {
+        return (uint8_t)(index << 3);
+    }
+};
+
+namespace ier {
+using reg = maus_bus::reg<chip, SC16_REG_IER>;
+inline constexpr field<reg, 0, 1> rhr_interrupt{};
+inline constexpr field<reg, 1, 1> thr_interrupt{};
+inline constexpr field<reg, 2, 1> line_status_interrupt{};
+inline constexpr field<reg, 3, 1> modem_status_interrupt{};
+inline constexpr field<reg, 4, 1> sleep_mode{};
+inline constexpr field<reg, 5, 1> xoff_interrupt{};
+inline constexpr field<reg, 6, 1> rts_interrupt{};
+inline constexpr field<reg, 7, 1> cts_interrupt{};
+} // namespace ier
+
+namespace fcr {
+using reg = maus_bus::reg<chip, SC16_REG_FCR, access::write_only>;
+inline constexpr field<reg, 0, 1> fifo_enable{};
+inline constexpr field<reg, 1, 1> reset_rx_fifo{};
+inline constexpr field<reg, 2, 1> reset_tx_fifo{};
+inline constexpr field<reg, 4, 2> tx_trigger{};
+inline constexpr field<reg, 6, 2> rx_trigger{};
+} // namespace fcr
+
+namespace lcr {
+using reg = maus_bus::reg<chip, SC16_REG_LCR>;
+inline constexpr field<reg, 0, 2, sc16_data_bits_t> word_length{};
+inline constexpr field<reg, 2, 1, sc16_stop_bits_t> stop_bits{};
+inline constexpr field<reg, 3, 3, sc16_parity_t> parity{};
+inline constexpr field<reg, 6, 1> break_control{};
+inline constexpr field<reg, 7, 1> divisor_latch{};
+} // namespace lcr
+
+namespace mcr {
+using reg = maus_bus::reg<chip, SC16_REG_MCR>;
+inline constexpr field<reg, 0, 1> dtr{};
+inline constexpr field<reg, 1, 1> rts{};
+inline constexpr field<reg, 2, 1> tcr_tlr_enable{};
+inline constexpr field<reg, 4, 1> loopback{};
+inline constexpr field<reg, 5, 1> xon_any{};
+inline constexpr field<reg, 6, 1> irda_mode{};
+inline constexpr field<reg, 7, 1> clock_divisor{};
+} // namespace mcr
+
+namespace lsr {
+using reg = maus_bus::reg<chip, SC16_REG_LSR, access::read_only>;
+inline constexpr field<reg, 0, 1> data_ready{};
+inline constexpr field<reg, 1, 1> overrun_error{};
+inline constexpr field<reg, 2, 1> parity_error{};
+inline constexpr field<reg, 3, 1> framing_error{};
+inline constexpr field<reg, 4, 1> break_interrupt{};
+inline constexpr field<reg, 5, 1> thr_empty{};
+inline constexpr field<reg, 6, 1> thr_tsr_empty{};
+inline constexpr field<reg, 7, 1> fifo_data_error{};
+} // namespace lsr
+
+namespace spr {
+using reg = maus_bus::reg<chip, SC16_REG_SPR>;
+inline constexpr field<reg, 0, 8> value{};
+} // namespace spr
+
+namespace txlvl {
+using reg = maus_bus::reg<chip, SC16_REG_TXLVL, access::read_only>;
+inline constexpr field<reg, 0, 7> space{};
+} // namespace txlvl
+
+namespace rxlvl {
+using reg = maus_bus::reg<chip, SC16_REG_RXLVL, access::read_only>;
+inline constexpr field<reg, 0, 7> count{};
+} // namespace rxlvl
+
+namespace efcr {
+using reg = maus_bus::reg<chip, SC16_REG_EFCR>;
+inline constexpr field<reg, 0, 1> nine_bit_mode{};
+inline constexpr field<reg, 1, 1> rx_disable{};
+inline constexpr field<reg, 2, 1> tx_disable{};
+inline constexpr field<reg, 4, 1> rts_control{};
+inline constexpr field<reg, 5, 1> rts_invert{};
+inline constexpr field<reg, 7, 1> irda_fast{};
+} // namespace efcr
+
+} // namespace sc16is740
+} // namespace maus_bus
+
+#endif
@@ -12,6 +12,14 @@ extern "C" {
 #define MAUS_BUS_VENDOR_MAX_LENGTH 23
 #define MAUS_BUS_PRODUCT_MAX_LENGTH 23
 
+#ifndef MAUS_BUS_SEGMENTS_MAX
+#define MAUS_BUS_SEGMENTS_MAX 8
+#endif
+
+#ifndef MAUS_BUS_BULK_CHUNK_SIZE
+#define MAUS_BUS_BULK_CHUNK_SIZE 16
+#endif
+
 /**
  * @brief Feature flags can be used as an alternative to VID/PID matching for generic plug-and-play
  * driver support.
@@ -24,8 +32,23 @@ typedef struct {
 
     uint32_t gpio : 1; // Device supports GPIO commands.
 
+    uint32_t bus_speed : 2; // Fastest bus clock the accessory's wiring allows, as a
+                            // maus_bus_speed_t plus one. 0 leaves it to the driver defaults.
+
 } maus_bus_device_features_t;
 
+// Masks for maus_bus_device_features_t as it appears in feature_flags.
+#define MAUS_BUS_FEATURE_TSCODE (1UL << 0)
+#define MAUS_BUS_FEATURE_SERIAL (1UL << 1)
+#define MAUS_BUS_FEATURE_GPIO (1UL << 2)
+#define MAUS_BUS_FEATURE_BUS_SPEED (3UL << 3)
+
+// Capabilities are the one-bit flags at the bottom of feature_flags, and the only bits the registry
+// indexes. Settings like bus_speed go above them. Grow this along with any new capability.
+#define MAUS_BUS_FEATURE_CAPABILITY_BITS 3
+#define MAUS_BUS_FEATURE_CAPABILITIES \
+    (MAUS_BUS_FEATURE_TSCODE | MAUS_BUS_FEATURE_SERIAL | MAUS_BUS_FEATURE_GPIO)
+
 /**
  * @brief Feature config flags. This can be used to define directly editing registers.
  */
@@ -96,35 +119,234 @@ typedef maus_bus_err_t (*maus_bus_master_read_fn
  */
 typedef maus_bus_err_t (*maus_bus_master_probe_fn)(uint8_t address);
 
+/**
+ * @brief One segment of a scatter-gather transfer. Segments are sent (or filled) back-to-back as a
+ * single transaction, so a header and a payload never need to be copied into one buffer.
+ */
+typedef struct {
+    uint8_t* data;
+    size_t len;
+} maus_bus_segment_t;
+
+/**
+ * @brief Optional vectored write callback. Implement this if your hardware can stream or DMA
+ * several buffers in one transaction.
+ */
+typedef maus_bus_err_t (*maus_bus_master_writev_fn
+)(uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count);
+
+/**
+ * @brief Optional vectored read callback, the reverse of maus_bus_master_writev_fn.
+ */
+typedef maus_bus_err_t (*maus_bus_master_readv_fn
+)(uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count);
+
+/**
+ * @brief Transaction priority classes. Lower values are more urgent.
+ */
+typedef enum {
+    MAUS_BUS_PRIORITY_REALTIME, // Latency-sensitive control: TS-Code, GPIO, motor stop.
+    MAUS_BUS_PRIORITY_NORMAL,   // Everything that doesn't say otherwise.
+    MAUS_BUS_PRIORITY_BULK,     // Scans, EEPROM dumps, large UART bursts. Split into chunks.
+    MAUS_BUS_PRIORITY_MAX,
+} maus_bus_priority_t;
+
+/**
+ * @brief Optional bus lock callback. It is taken around every transaction, and around every chunk
+ * of a bulk transfer, so a realtime caller waiting on it gets in between chunks. Implement it with
+ * whatever your RTOS offers, granting waiters in priority order.
+ */
+typedef maus_bus_err_t (*maus_bus_lock_fn)(maus_bus_priority_t priority);
+
+/**
+ * @brief Releases the lock taken by maus_bus_lock_fn.
+ */
+typedef void (*maus_bus_unlock_fn)(void);
+
+/**
+ * @brief Optional monotonic clock, in microseconds. Used to measure queueing delay.
+ */
+typedef uint32_t (*maus_bus_clock_fn)(void);
+
+/**
+ * @brief Optional hook to retune the bus for the next device. It is called before a transaction
+ * whenever the target differs from the last one configured, so consecutive transactions to the
+ * same device don't pay for it again.
+ *
+ * @param address Device the next transactions go to.
+ * @param clock_hz Bus clock the device supports.
+ * @param timeout_us How long one transaction may take before the backend should give up and
+ * return MAUS_BUS_TIMEOUT.
+ */
+typedef maus_bus_err_t (*maus_bus_configure_target_fn
+)(uint8_t address, uint32_t clock_hz, uint32_t timeout_us);
+
+/**
+ * @brief Optional delay, in microseconds, used to back off between retries. Without it retries
+ * follow each other immediately.
+ */
+typedef void (*maus_bus_delay_fn)(uint32_t us);
+
 /**
  * @brief Configuration struct for integrating Maus-Bus driver into your hardware.
+ *
+ * The writev and readv callbacks are optional. Without them, vectored calls are staged through a
+ * temporary buffer and passed to write and read. lock, unlock, clock_us, configure_target and
+ * delay_us are optional too.
  */
 typedef struct {
     maus_bus_master_read_fn read;
     maus_bus_master_write_fn write;
     maus_bus_master_probe_fn probe;
+    maus_bus_master_writev_fn writev;
+    maus_bus_master_readv_fn readv;
+    maus_bus_lock_fn lock;
+    maus_bus_unlock_fn unlock;
+    maus_bus_clock_fn clock_us;
+    maus_bus_configure_target_fn configure_target;
+    maus_bus_delay_fn delay_us;
 } maus_bus_config_t;
 
+/**
+ * @brief I2C speed classes.
+ */
+typedef enum {
+    MAUS_BUS_SPEED_STANDARD,  // 100kHz
+    MAUS_BUS_SPEED_FAST,      // 400kHz
+    MAUS_BUS_SPEED_FAST_PLUS, // 1MHz
+} maus_bus_speed_t;
+
+#ifndef MAUS_BUS_DEFAULT_TIMEOUT_US
+#define MAUS_BUS_DEFAULT_TIMEOUT_US 10000
+#endif
+
+#ifndef MAUS_BUS_DEFAULT_RETRIES
+#define MAUS_BUS_DEFAULT_RETRIES 2
+#endif
+
+#ifndef MAUS_BUS_DEFAULT_BACKOFF_US
+#define MAUS_BUS_DEFAULT_BACKOFF_US 200
+#endif
+
+#ifndef MAUS_BUS_DEFAULT_BACKOFF_MAX_US
+#define MAUS_BUS_DEFAULT_BACKOFF_MAX_US 2000
+#endif
+
+#ifndef MAUS_BUS_DEFAULT_FAIL_THRESHOLD
+#define MAUS_BUS_DEFAULT_FAIL_THRESHOLD 3
+#endif
+
+#ifndef MAUS_BUS_DEFAULT_COOLDOWN_US
+#define MAUS_BUS_DEFAULT_COOLDOWN_US 250000
+#endif
+
+/**
+ * @brief How the bus treats one device: how fast to clock it, how long to wait for it, and how
+ * hard to try before giving up on it.
+ *
+ * A read or write that fails is retried up to retries times, waiting backoff_us before the first
+ * retry and doubling up to backoff_max_us. After fail_threshold transactions in a row fail, even
+ * with retries, the device fails fast: calls return MAUS_BUS_UNAVAILABLE without touching the bus
+ * until cooldown_us has passed, then one attempt is let through to see if it has recovered.
+ * Without a clock_us callback, that attempt comes after fail_threshold rejected calls instead.
+ *
+ * Only plain register reads and writes are retried. FIFO accesses (maus_bus_*_fifo_prio) get one
+ * attempt, because the failed one may already have moved data, but a device that keeps failing
+ * them still fails fast. Probes and scans are never retried and never trip the breaker. Not
+ * answering is what they are there to find out.
+ */
+typedef struct {
+    maus_bus_speed_t speed;
+    uint32_t timeout_us;     // Passed to configure_target.
+    uint8_t retries;         // Extra attempts after a failure. 0 disables retrying.
+    uint16_t backoff_us;     // Wait before the first retry.
+    uint16_t backoff_max_us; // Longest wait between retries.
+    uint8_t fail_threshold;  // Failed transactions in a row before failing fast. 0 disables it.
+    uint32_t cooldown_us;    // How long to fail fast before trying the device again.
+} maus_bus_profile_t;
+
+/**
+ * @brief Retry and fail-fast counters, across all devices.
+ */
+typedef struct {
+    uint32_t retries;  // Attempts repeated after a failure.
+    uint32_t timeouts; // Transactions that ended in MAUS_BUS_TIMEOUT from the backend.
+    uint32_t opened;   // Times a device started failing fast.
+    uint32_t rejected; // Calls answered with MAUS_BUS_UNAVAILABLE without touching the bus.
+} maus_bus_retry_stats_t;
+
+/**
+ * @brief Per-class dispatch counters. Waits are only measured if a clock_us callback is set.
+ */
+typedef struct {
+    uint32_t transactions;  // Calls made at this priority.
+    uint32_t chunks;        // Times the bus was taken, more than transactions for bulk transfers.
+    uint32_t max_wait_us;   // Worst-case time spent queueing for the bus.
+    uint64_t total_wait_us; // Divide by chunks for the average.
+} maus_bus_priority_stats_t;
+
 /**
  * @brief Addresses are a null-terminated array of bytes.
  * Each step in the address is one hop through a multiplexer.
  */
 typedef uint8_t* maus_bus_address_t;
 
+#ifndef MAUS_BUS_ADDRESS_MAX_DEPTH
+#define MAUS_BUS_ADDRESS_MAX_DEPTH 4
+#endif
+
+#ifndef MAUS_BUS_REGISTRY_MAX
+#define MAUS_BUS_REGISTRY_MAX 32
+#endif
+
+#if MAUS_BUS_REGISTRY_MAX > 32
+#error "MAUS_BUS_REGISTRY_MAX must fit in a maus_bus_device_set_t"
+#endif
+
+/**
+ * @brief A set of registered devices, one bit per registry slot. Sets from different queries can
+ * be combined with & and |, and are walked with maus_bus_enumerate_set.
+ *
+ * A set is a snapshot: it stays valid until the next register or unregister call.
+ */
+typedef uint32_t maus_bus_device_set_t;
+
+#ifndef MAUS_BUS_RECORD_MAX
+#define MAUS_BUS_RECORD_MAX 48
+#endif
+
+/**
+ * @brief Refers to one stored device record, shared by the scan results, the registry and the
+ * application. Handles carry a generation, so a handle to a record that has since been freed or
+ * unregistered is detected instead of resolving to whatever took its place.
+ */
+typedef uint32_t maus_bus_handle_t;
+
+#define MAUS_BUS_HANDLE_INVALID ((maus_bus_handle_t)0)
+
+/**
+ * @brief Link status of a registered device.
+ */
 typedef enum {
-    MAUS_BUS_STATUS_CONNECTED,
-    MAUS_BUS_STATUS_PROBED,
-    MAUS_BUS_STATUS_TIMEOUT,
-    MAUS_BUS_STATUS_DISCONNECTED,
+    MAUS_BUS_STATUS_CONNECTED,    // Identified and bound to its driver.
+    MAUS_BUS_STATUS_PROBED,       // Answering, but its ID no longer matches what was registered.
+    MAUS_BUS_STATUS_TIMEOUT,      // Last access timed out, it may still come back.
+    MAUS_BUS_STATUS_DISCONNECTED, // Not answering at all.
 } maus_bus_status_t;
 
+/**
+ * @brief UART driver. set_mode takes data bits (5-8), a parity value and stop bits (1-2), and may
+ * be NULL for drivers that have no line settings.
+ */
 typedef struct maus_bus_uart_driver {
     maus_bus_err_t (*transmit)(uint8_t* data, size_t length);
+    maus_bus_err_t (*transmitv)(const maus_bus_segment_t* segments, size_t count);
     maus_bus_err_t (*receive)(uint8_t* data, size_t* count, size_t max_length);
     maus_bus_err_t (*set_mode)(uint32_t baud, uint8_t data, uint8_t parity, uint8_t stop);
 } maus_bus_uart_driver_t;
 
 typedef struct maus_bus_gpio_driver {
+    uint8_t address; // Expander to pass to the functions below. See maus_bus_set_gpio_address.
     maus_bus_err_t (*mode)(uint8_t address, uint8_t gpio_num, pca9554_gpio_mode_t mode);
     maus_bus_err_t (*set)(uint8_t address, uint8_t gpio_num, pca9554_gpio_level_t level);
     maus_bus_err_t (*get)(uint8_t address, uint8_t gpio_num, pca9554_gpio_level_t* level);
@@ -160,6 +382,159 @@ maus_bus_err_t maus_bus_write_str(uint8_t address, uint8_t subaddress, char* str
 maus_bus_err_t maus_bus_read(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len);
 maus_bus_err_t maus_bus_read_byte(uint8_t address, uint8_t subaddress, uint8_t* data);
 
+/**
+ * @brief Writes at the given priority.
+ *
+ * Bulk writes are split into MAUS_BUS_BULK_CHUNK_SIZE chunks with the subaddress advancing by the
+ * chunk length, which matches EEPROM-style sequential access. Use maus_bus_write_fifo_prio for
+ * FIFO registers.
+ *
+ * @param priority
+ * @param address
+ * @param subaddress
+ * @param data
+ * @param len
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_write_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+);
+
+/**
+ * @brief Reads at the given priority. Bulk reads are chunked the same way as maus_bus_write_prio.
+ *
+ * @param priority
+ * @param address
+ * @param subaddress
+ * @param data
+ * @param len
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_read_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+);
+
+/**
+ * @brief Writes to a FIFO register, e.g. a UART's THR. Unlike maus_bus_write_prio, this is never
+ * retried: a NACK partway through can come after the device took some of the bytes, and sending
+ * them again would duplicate them. Bulk chunks all go to the same subaddress. The fail-fast
+ * breaker still applies.
+ *
+ * @param priority
+ * @param address
+ * @param subaddress
+ * @param data
+ * @param len
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_write_fifo_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+);
+
+/**
+ * @brief Reads from a FIFO register, e.g. a UART's RHR. Never retried, since bytes popped by a
+ * failed attempt are gone. See maus_bus_write_fifo_prio.
+ *
+ * @param priority
+ * @param address
+ * @param subaddress
+ * @param data
+ * @param len
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_read_fifo_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+);
+
+/**
+ * @brief Vectored write at the given priority. See maus_bus_writev.
+ */
+maus_bus_err_t maus_bus_writev_prio(
+    maus_bus_priority_t priority,
+    uint8_t address,
+    uint8_t subaddress,
+    const maus_bus_segment_t* segments,
+    size_t count
+);
+
+/**
+ * @brief Vectored write to a FIFO register. See maus_bus_write_fifo_prio.
+ */
+maus_bus_err_t maus_bus_writev_fifo_prio(
+    maus_bus_priority_t priority,
+    uint8_t address,
+    uint8_t subaddress,
+    const maus_bus_segment_t* segments,
+    size_t count
+);
+
+/**
+ * @brief Vectored read at the given priority. See maus_bus_readv. Bulk reads are chunked like
+ * maus_bus_read_prio's.
+ */
+maus_bus_err_t maus_bus_readv_prio(
+    maus_bus_priority_t priority,
+    uint8_t address,
+    uint8_t subaddress,
+    const maus_bus_segment_t* segments,
+    size_t count
+);
+
+/**
+ * @brief Reads the dispatch counters for one priority class, including the worst-case queueing
+ * delay seen since the last reset.
+ *
+ * @param priority
+ * @param stats
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t
+maus_bus_get_priority_stats(maus_bus_priority_t priority, maus_bus_priority_stats_t* stats);
+void maus_bus_reset_priority_stats(void);
+
+/**
+ * @brief Current time from the configured clock_us callback, or 0 if there isn't one.
+ */
+uint32_t maus_bus_now_us(void);
+
+/**
+ * @brief Checks whether anything ACKs the given address.
+ *
+ * @param address
+ * @return maus_bus_err_t MAUS_BUS_OK if a device answered.
+ */
+maus_bus_err_t maus_bus_probe(uint8_t address);
+
+/**
+ * @brief Writes several segments as one transaction, without copying them together first.
+ *
+ * Empty segments are skipped. If no writev callback was configured, the segments are staged
+ * through a temporary buffer (unless only one of them has data). Either way, bulk writes are
+ * chunked like maus_bus_write_prio's, wherever the segment boundaries fall.
+ *
+ * @param address
+ * @param subaddress
+ * @param segments
+ * @param count Number of segments, at most MAUS_BUS_SEGMENTS_MAX.
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_writev(
+    uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count
+);
+
+/**
+ * @brief Reads one transaction and scatters it across several segments.
+ *
+ * @param address
+ * @param subaddress
+ * @param segments
+ * @param count Number of segments, at most MAUS_BUS_SEGMENTS_MAX.
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_readv(
+    uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count
+);
+
 /**
  * @brief Scans the accessory bus only walking hubs and ID chips.
  *
@@ -186,11 +561,50 @@ size_t maus_bus_scan_bus_full(maus_bus_scan_callback_t cb, void* ptr);
 /**
  * @brief Frees the internal device list generated from the last scan.
  *
- * Be sure to call this when you're done with the scan results! All device pointers will be freed,
- * so be sure to copy those to your own structure.
+ * Be sure to call this when you're done with the scan results! Records of registered devices, or
+ * ones retained with maus_bus_device_retain, are kept. Pointers to any other scan result are
+ * invalid afterwards.
  */
 void maus_bus_free_device_scan(void);
 
+/**
+ * @brief Handle for the device at an address, from the registry if it is registered, otherwise
+ * from the last scan. The handle isn't retained.
+ *
+ * @param address
+ * @return maus_bus_handle_t MAUS_BUS_HANDLE_INVALID if nothing is known at the address.
+ */
+maus_bus_handle_t maus_bus_device_handle(maus_bus_address_t address);
+
+/**
+ * @brief Takes a reference, keeping the record alive across maus_bus_free_device_scan and
+ * maus_bus_unregister_device until the matching maus_bus_device_release.
+ *
+ * @param handle
+ * @return maus_bus_handle_t The same handle, or MAUS_BUS_HANDLE_INVALID if it was already stale.
+ */
+maus_bus_handle_t maus_bus_device_retain(maus_bus_handle_t handle);
+
+/**
+ * @brief Gives back a reference taken with maus_bus_device_retain. Pass the handle retain
+ * returned, even if unregistering the device has made it stale since.
+ */
+void maus_bus_device_release(maus_bus_handle_t handle);
+
+/**
+ * @brief Resolves a handle. This is a bounds and generation check, so it is cheap enough to call
+ * before every use.
+ *
+ * @param handle
+ * @return const maus_bus_device_t* NULL if the handle is stale or the device was unregistered.
+ */
+const maus_bus_device_t* maus_bus_device_get(maus_bus_handle_t handle);
+
+/**
+ * @brief The address stored with a record. Same lifetime rules as maus_bus_device_get.
+ */
+maus_bus_address_t maus_bus_device_address(maus_bus_handle_t handle);
+
 /**
  * @brief returns false if addresses are not the same
  *
@@ -202,18 +616,36 @@ int maus_bus_addrcmp(maus_bus_address_t a, maus_bus_address_t b);
 
 size_t maus_bus_addr2str(char* str, size_t max_len, maus_bus_address_t address);
 
+/**
+ * @brief Number of hops in an address, not counting the terminator.
+ */
+size_t maus_bus_get_address_depth(maus_bus_address_t address);
+
+/**
+ * @brief The device's own address on the last hop.
+ */
+uint8_t maus_bus_get_final_address(maus_bus_address_t address);
+
 // Scan Functions
 
-maus_bus_device_t* maus_bus_get_scan_item_by_address(maus_bus_address_t address);
+/**
+ * @brief The last scan's record for an address. The record is shared with the registry and every
+ * handle to it, so it is read-only.
+ *
+ * @param address
+ * @return const maus_bus_device_t* NULL if the last scan found nothing there.
+ */
+const maus_bus_device_t* maus_bus_get_scan_item_by_address(maus_bus_address_t address);
 void maus_bus_free_driver(maus_bus_driver_t* driver);
 
 /**
  * @brief Registers a device and allocates a driver.
  *
- * This MUST be called while scan results are still available.
+ * This MUST be called while scan results are still available. Registering an address twice is a
+ * no-op.
  *
  * @param address
- * @return maus_bus_err_t
+ * @return maus_bus_err_t MAUS_BUS_NO_MEMORY once MAUS_BUS_REGISTRY_MAX devices are registered.
  */
 maus_bus_err_t maus_bus_register_device(maus_bus_address_t address);
 
@@ -229,6 +661,140 @@ typedef void (*maus_bus_enumeration_callback_t
  */
 maus_bus_err_t maus_bus_enumerate_devices(maus_bus_enumeration_callback_t cb, void* ptr);
 
+/**
+ * @brief Removes a registered device and frees its driver.
+ *
+ * @param address
+ * @return maus_bus_err_t MAUS_BUS_FAIL if the device isn't registered.
+ */
+maus_bus_err_t maus_bus_unregister_device(maus_bus_address_t address);
+
+/**
+ * @brief Like maus_bus_enumerate_devices, but only visits the devices in a set. The cost is
+ * proportional to the size of the set, not to the number of registered devices.
+ *
+ * @param set
+ * @param cb
+ * @param ptr
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t
+maus_bus_enumerate_set(maus_bus_device_set_t set, maus_bus_enumeration_callback_t cb, void* ptr);
+
+/**
+ * @brief Registered devices that have every feature in the mask, e.g. MAUS_BUS_FEATURE_SERIAL.
+ * A mask of 0 matches every registered device. Only capabilities can be queried, a mask with bits
+ * outside MAUS_BUS_FEATURE_CAPABILITIES matches nothing.
+ *
+ * @param feature_flags
+ * @return maus_bus_device_set_t
+ */
+maus_bus_device_set_t maus_bus_query_features(uint32_t feature_flags);
+
+/**
+ * @brief Registered devices with exactly this product_type.
+ *
+ * @param product_type
+ * @return maus_bus_device_set_t
+ */
+maus_bus_device_set_t maus_bus_query_product_type(uint16_t product_type);
+
+/**
+ * @brief Registered devices whose status is MAUS_BUS_STATUS_CONNECTED. AND this with another query
+ * to skip devices that have gone away.
+ *
+ * @return maus_bus_device_set_t
+ */
+maus_bus_device_set_t maus_bus_query_connected(void);
+
+size_t maus_bus_device_set_count(maus_bus_device_set_t set);
+
+/**
+ * @brief Clock rate of a speed class.
+ *
+ * @param speed
+ * @return uint32_t Hz.
+ */
+uint32_t maus_bus_speed_hz(maus_bus_speed_t speed);
+
+/**
+ * @brief Bus clock transactions to an address run at: the speed of the profile bound to it, merged
+ * across every registered device that uses it, or the default profile's if none does. Use this to
+ * estimate on-wire time.
+ *
+ * @param address 7-bit address.
+ * @return uint32_t
+ */
+uint32_t maus_bus_target_clock_hz(uint8_t address);
+
+/**
+ * @brief Reads the profile of a registered device.
+ *
+ * Profiles are set up on registration: speed comes from the bus_speed feature bits if the EEPROM
+ * declares one (MAUS_BUS_SPEED_STANDARD is stored as 1), otherwise from what the bound drivers'
+ * chips support. Timing comes from the default
+ * profile. The profile also covers the chips the driver talks to, e.g. the SC16IS740 behind a
+ * serial accessory's EEPROM.
+ *
+ * When several registered devices talk to the same chip, it runs with all of their profiles merged:
+ * the slowest speed and longest timeout, the fewest retries and longest backoff, and the lowest
+ * fail_threshold and longest cooldown. This returns the device's own profile, not the merged one.
+ *
+ * @param address
+ * @param profile
+ * @return maus_bus_err_t MAUS_BUS_FAIL if the device isn't registered.
+ */
+maus_bus_err_t maus_bus_get_device_profile(maus_bus_address_t address, maus_bus_profile_t* profile);
+
+/**
+ * @brief Overrides the profile of a registered device.
+ *
+ * @param address
+ * @param profile
+ * @return maus_bus_err_t MAUS_BUS_FAIL if the device isn't registered.
+ */
+maus_bus_err_t
+maus_bus_set_device_profile(maus_bus_address_t address, const maus_bus_profile_t* profile);
+
+/**
+ * @brief Points a registered device's GPIO driver at the expander it actually has. Drivers start
+ * out at PCA9554_ADDRESS. The device's profile moves along with it.
+ *
+ * @param address Device address.
+ * @param expander 7-bit expander address.
+ * @return maus_bus_err_t MAUS_BUS_NOT_SUPPORTED if the device has no GPIO driver.
+ */
+maus_bus_err_t maus_bus_set_gpio_address(maus_bus_address_t address, uint8_t expander);
+
+/**
+ * @brief The profile used for addresses no registered device claims, and the template for new
+ * registrations.
+ */
+void maus_bus_get_default_profile(maus_bus_profile_t* profile);
+void maus_bus_set_default_profile(const maus_bus_profile_t* profile);
+
+void maus_bus_get_retry_stats(maus_bus_retry_stats_t* stats);
+void maus_bus_reset_retry_stats(void);
+
+/**
+ * @brief Reads the link status of a registered device.
+ *
+ * @param address
+ * @param status
+ * @return maus_bus_err_t MAUS_BUS_FAIL if the device isn't registered.
+ */
+maus_bus_err_t maus_bus_get_device_status(maus_bus_address_t address, maus_bus_status_t* status);
+
+/**
+ * @brief Updates the link status of a registered device. This is normally driven by the hotplug
+ * pipeline (see maus_bus_hotplug.h), but applications may set it too.
+ *
+ * @param address
+ * @param status
+ * @return maus_bus_err_t MAUS_BUS_FAIL if the device isn't registered.
+ */
+maus_bus_err_t maus_bus_set_device_status(maus_bus_address_t address, maus_bus_status_t status);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,555 @@
+#ifndef __mt_accessory_common__maus_bus_coro_hpp
+#define __mt_accessory_common__maus_bus_coro_hpp
+
+/**
+ * Coroutine façade for Maus-Bus I/O. C++20, header-only, optional.
+ *
+ * Multi-step accessory protocols are written as straight-line coroutines instead of state
+ * machines, and any number of them share one thread. An executor owns the sessions and is polled
+ * from wherever suits: an RTOS task, a Linux event loop, the main loop.
+ *
+ *   maus_bus::task query(maus_bus::executor& ex, maus_bus_uart_driver_t* uart) {
+ *       uint8_t cmd[] = { 'V', '\n' };
+ *       uint8_t reply[32];
+ *       size_t count = 0;
+ *
+ *       maus_bus_err_t err = co_await ex.transmit(uart, cmd, sizeof(cmd));
+ *       if (err == MAUS_BUS_OK) err = co_await ex.receive(uart, reply, &count, sizeof(reply), 50);
+ *       co_return err;
+ *   }
+ *
+ *   maus_bus::executor ex;
+ *   ex.spawn(query(ex, driver->uart));
+ *   while (!ex.empty()) ex.poll(now_ms());
+ *
+ * The underlying C calls still block while they are on the wire. What the executor adds is that
+ * every transaction is a scheduling point: a poll runs at most one step of each waiting session,
+ * so one session's long exchange can't starve the others. Waiting, on a timer or for RX data,
+ * never blocks at all.
+ *
+ * Nothing here allocates apart from coroutine frames. Waiting sessions are linked through their
+ * awaiters, which live in those frames. Destroying the executor destroys the frames of sessions
+ * that haven't finished.
+ */
+
+#include "maus_bus.h"
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
+
+namespace maus_bus {
+
+class executor;
+
+namespace detail {
+
+/**
+ * @brief A suspended session, waiting in the executor for step() to report it can continue.
+ */
+struct pending {
+    pending* next = nullptr;
+    std::coroutine_handle<> handle;
+
+    virtual bool step(uint32_t now_ms) = 0;
+
+  protected:
+    ~pending() = default;
+};
+
+/**
+ * @brief Links a spawned session into its executor, so a frame still suspended when the executor
+ * goes away can be destroyed instead of leaked.
+ */
+struct session {
+    session* prev = nullptr;
+    session* next = nullptr;
+    std::coroutine_handle<> root;
+};
+
+} // namespace detail
+
+/**
+ * @brief Single-threaded executor. Not thread-safe: spawn and poll from the same thread.
+ */
+class executor {
+  public:
+    executor() = default;
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    /**
+     * @brief Destroys sessions that haven't finished, along with every task they were awaiting.
+     * Their done callbacks are not called.
+     */
+    ~executor() {
+        _head = nullptr;
+        _tail = nullptr;
+
+        while (_sessions != nullptr) {
+            detail::session* s = _sessions;
+            _sessions = s->next;
+            s->root.destroy();
+        }
+
+        _active = 0;
+    }
+
+    /**
+     * @brief Runs one step of every waiting session: timers and RX waits are checked, queued
+     * transactions are issued, and whoever can continue is resumed until it suspends again.
+     *
+     * @param now_ms Monotonic time in milliseconds.
+     * @return size_t Sessions resumed.
+     */
+    size_t poll(uint32_t now_ms) {
+        detail::pending* list = _head;
+        size_t resumed = 0;
+
+        _now_ms = now_ms;
+        _head = nullptr;
+        _tail = nullptr;
+
+        // Anything that suspends while being resumed lands on the fresh list, so it waits for the
+        // next poll instead of looping here forever.
+        while (list != nullptr) {
+            detail::pending* p = list;
+            list = list->next;
+            p->next = nullptr;
+
+            if (p->step(now_ms)) {
+                p->handle.resume();
+                resumed++;
+            } else {
+                enqueue(p);
+            }
+        }
+
+        return resumed;
+    }
+
+    /**
+     * @brief True when no session is waiting. Spawned sessions are waiting until they finish.
+     */
+    bool empty() const {
+        return _head == nullptr;
+    }
+
+    /**
+     * @brief Sessions spawned and not yet finished.
+     */
+    size_t active() const {
+        return _active;
+    }
+
+    /**
+     * @brief The time passed to the last poll. Timeouts count from here.
+     */
+    uint32_t now() const {
+        return _now_ms;
+    }
+
+    template <typename Task>
+    void
+    spawn(Task&& t, void (*done)(maus_bus_err_t err, void* ptr) = nullptr, void* ptr = nullptr);
+
+    // Awaitables. Each returns maus_bus_err_t from co_await.
+
+    auto read(
+        uint8_t address,
+        uint8_t subaddress,
+        uint8_t* data,
+        size_t len,
+        maus_bus_priority_t priority = MAUS_BUS_PRIORITY_NORMAL
+    );
+    auto write(
+        uint8_t address,
+        uint8_t subaddress,
+        uint8_t* data,
+        size_t len,
+        maus_bus_priority_t priority = MAUS_BUS_PRIORITY_NORMAL
+    );
+
+    /**
+     * @brief Issues any blocking driver call returning maus_bus_err_t as one scheduling step,
+     * e.g. a GPIO vtable entry.
+     */
+    template <typename F>
+    auto call(F&& fn);
+
+    auto transmit(maus_bus_uart_driver_t* uart, uint8_t* data, size_t length);
+    auto set_gpio(
+        maus_bus_gpio_driver_t* gpio, uint8_t address, uint8_t num, pca9554_gpio_level_t level
+    );
+    auto get_gpio(
+        maus_bus_gpio_driver_t* gpio, uint8_t address, uint8_t num, pca9554_gpio_level_t* level
+    );
+
+    /**
+     * @brief Polls the UART once per executor poll until data arrives or timeout_ms passes. count
+     * may be NULL, like it can for the driver's receive.
+     *
+     * @return MAUS_BUS_TIMEOUT if nothing arrived in time, with *count left at 0.
+     */
+    auto receive(
+        maus_bus_uart_driver_t* uart,
+        uint8_t* data,
+        size_t* count,
+        size_t max_length,
+        uint32_t timeout_ms
+    );
+
+    auto sleep(uint32_t ms);
+
+    /**
+     * @brief Waits until pred() returns true, checking once per poll. The predicate may touch the
+     * bus, but keep it to one transaction.
+     *
+     * @return MAUS_BUS_TIMEOUT if timeout_ms passes first.
+     */
+    template <typename Pred>
+    auto until(Pred&& pred, uint32_t timeout_ms);
+
+    void enqueue(detail::pending* p) {
+        p->next = nullptr;
+
+        if (_tail == nullptr) {
+            _head = p;
+        } else {
+            _tail->next = p;
+        }
+
+        _tail = p;
+    }
+
+  private:
+    friend class task;
+
+    void adopt(detail::session* s) {
+        s->prev = nullptr;
+        s->next = _sessions;
+        if (_sessions != nullptr) _sessions->prev = s;
+        _sessions = s;
+        _active++;
+    }
+
+    void finish(detail::session* s) {
+        if (s->prev != nullptr) s->prev->next = s->next;
+        if (s->next != nullptr) s->next->prev = s->prev;
+        if (_sessions == s) _sessions = s->next;
+        _active--;
+    }
+
+    detail::pending* _head = nullptr;
+    detail::pending* _tail = nullptr;
+    detail::session* _sessions = nullptr;
+    size_t _active = 0;
+    uint32_t _now_ms = 0;
+};
+
+namespace detail {
+
+/**
+ * @brief Common awaiter plumbing: always suspend, park in the executor, hand back the result.
+ */
+struct awaiter_base : pending {
+    explicit awaiter_base(executor& ex) : ex(ex) {}
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        handle = h;
+        ex.enqueue(this);
+    }
+
+    maus_bus_err_t await_resume() const noexcept {
+        return err;
+    }
+
+    executor& ex;
+    maus_bus_err_t err = MAUS_BUS_OK;
+};
+
+static inline bool expired(uint32_t now_ms, uint32_t deadline_ms) {
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+template <typename F>
+struct call_awaiter final : awaiter_base {
+    call_awaiter(executor& ex, F fn) : awaiter_base(ex), fn(std::move(fn)) {}
+
+    bool step(uint32_t) override {
+        err = fn();
+        return true;
+    }
+
+    F fn;
+};
+
+struct sleep_awaiter final : awaiter_base {
+    sleep_awaiter(executor& ex, uint32_t deadline_ms)
+        : awaiter_base(ex), deadline_ms(deadline_ms) {}
+
+    bool step(uint32_t now_ms) override {
+        return expired(now_ms, deadline_ms);
+    }
+
+    uint32_t deadline_ms;
+};
+
+template <typename Pred>
+struct until_awaiter final : awaiter_base {
+    until_awaiter(executor& ex, Pred pred, uint32_t deadline_ms)
+        : awaiter_base(ex), pred(std::move(pred)), deadline_ms(deadline_ms) {}
+
+    bool step(uint32_t now_ms) override {
+        if (pred()) return true;
+        if (!expired(now_ms, deadline_ms)) return false;
+
+        err = MAUS_BUS_TIMEOUT;
+        return true;
+    }
+
+    Pred pred;
+    uint32_t deadline_ms;
+};
+
+struct receive_awaiter final : awaiter_base {
+    receive_awaiter(
+        executor& ex,
+        maus_bus_uart_driver_t* uart,
+        uint8_t* data,
+        size_t* count,
+        size_t max_length,
+        uint32_t deadline_ms
+    )
+        : awaiter_base(ex), uart(uart), data(data), count(count), max_length(max_length),
+          deadline_ms(deadline_ms) {
+        if (count != nullptr) *count = 0;
+    }
+
+    bool step(uint32_t now_ms) override {
+        if (uart == nullptr || uart->receive == nullptr) {
+            err = MAUS_BUS_NOT_SUPPORTED;
+            return true;
+        }
+
+        // count is optional for the caller, but it's how we know something arrived. Not every
+        // driver clears it when there is nothing to read.
+        size_t& received = count != nullptr ? *count : _received;
+        received = 0;
+        err = uart->receive(data, &received, max_length);
+        if (err != MAUS_BUS_OK || received > 0) return true;
+        if (!expired(now_ms, deadline_ms)) return false;
+
+        err = MAUS_BUS_TIMEOUT;
+        return true;
+    }
+
+    maus_bus_uart_driver_t* uart;
+    uint8_t* data;
+    size_t* count;
+    size_t max_length;
+    uint32_t deadline_ms;
+    size_t _received = 0;
+};
+
+/**
+ * @brief Parks a freshly spawned session until the first poll.
+ */
+struct start : pending {
+    bool step(uint32_t) override {
+        return true;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief A session, or a step of one. co_return a maus_bus_err_t. Tasks start suspended and run
+ * when spawned on an executor or awaited by another task, which resumes once it finishes.
+ */
+class task {
+  public:
+    struct promise_type;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    struct final_awaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(handle_type h) noexcept {
+            promise_type& p = h.promise();
+            if (p.continuation) return p.continuation;
+
+            // Spawned: nobody is waiting on this frame, so it is ours to clean up.
+            if (p.ex != nullptr) {
+                p.ex->finish(&p.session);
+                if (p.done != nullptr) p.done(p.result, p.done_ptr);
+                h.destroy();
+            }
+
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        maus_bus_err_t result = MAUS_BUS_OK;
+        std::coroutine_handle<> continuation;
+
+        // Only set for spawned sessions.
+        executor* ex = nullptr;
+        void (*done)(maus_bus_err_t err, void* ptr) = nullptr;
+        void* done_ptr = nullptr;
+        detail::start starter;
+        detail::session session;
+
+        task get_return_object() {
+            return task(handle_type::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        final_awaiter final_suspend() noexcept {
+            return {};
+        }
+
+        void return_value(maus_bus_err_t err) {
+            result = err;
+        }
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+
+    task(task&& other) noexcept : _handle(std::exchange(other._handle, nullptr)) {}
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    task& operator=(task&&) = delete;
+
+    ~task() {
+        if (_handle) _handle.destroy();
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        _handle.promise().continuation = caller;
+        return _handle;
+    }
+
+    maus_bus_err_t await_resume() const noexcept {
+        return _handle.promise().result;
+    }
+
+  private:
+    friend class executor;
+
+    explicit task(handle_type h) : _handle(h) {}
+
+    handle_type release() {
+        return std::exchange(_handle, nullptr);
+    }
+
+    handle_type _handle;
+};
+
+/**
+ * @brief Hands a session to the executor. It starts on the next poll, and its frame is freed
+ * when it finishes, after done is called with its result.
+ */
+template <typename Task>
+void executor::spawn(Task&& t, void (*done)(maus_bus_err_t err, void* ptr), void* ptr) {
+    static_assert(std::is_same_v<std::decay_t<Task>, task>, "only maus_bus::task can be spawned");
+
+    task::handle_type h = t.release();
+    task::promise_type& p = h.promise();
+
+    p.ex = this;
+    p.done = done;
+    p.done_ptr = ptr;
+    p.starter.handle = h;
+    p.session.root = h;
+
+    adopt(&p.session);
+    enqueue(&p.starter);
+}
+
+template <typename F>
+auto executor::call(F&& fn) {
+    return detail::call_awaiter<std::decay_t<F>>(*this, std::forward<F>(fn));
+}
+
+inline auto executor::read(
+    uint8_t address, uint8_t subaddress, uint8_t* data, size_t len, maus_bus_priority_t priority
+) {
+    return call([=] { return maus_bus_read_prio(priority, address, subaddress, data, len); });
+}
+
+inline auto executor::write(
+    uint8_t address, uint8_t subaddress, uint8_t* data, size_t len, maus_bus_priority_t priority
+) {
+    return call([=] { return maus_bus_write_prio(priority, address, subaddress, data, len); });
+}
+
+inline auto executor::transmit(maus_bus_uart_driver_t* uart, uint8_t* data, size_t length) {
+    return call([=] {
+        if (uart == nullptr || uart->transmit == nullptr) return MAUS_BUS_NOT_SUPPORTED;
+        return uart->transmit(data, length);
+    });
+}
+
+inline auto executor::set_gpio(
+    maus_bus_gpio_driver_t* gpio, uint8_t address, uint8_t num, pca9554_gpio_level_t level
+) {
+    return call([=] {
+        if (gpio == nullptr || gpio->set == nullptr) return MAUS_BUS_NOT_SUPPORTED;
+        return gpio->set(address, num, level);
+    });
+}
+
+inline auto executor::get_gpio(
+    maus_bus_gpio_driver_t* gpio, uint8_t address, uint8_t num, pca9554_gpio_level_t* level
+) {
+    return call([=] {
+        if (gpio == nullptr || gpio->get == nullptr) return MAUS_BUS_NOT_SUPPORTED;
+        return gpio->get(address, num, level);
+    });
+}
+
+inline auto executor::receive(
+    maus_bus_uart_driver_t* uart,
+    uint8_t* data,
+    size_t* count,
+    size_t max_length,
+    uint32_t timeout_ms
+) {
+    return detail::receive_awaiter(*this, uart, data, count, max_length, _now_ms + timeout_ms);
+}
+
+inline auto executor::sleep(uint32_t ms) {
+    return detail::sleep_awaiter(*this, _now_ms + ms);
+}
+
+template <typename Pred>
+auto executor::until(Pred&& pred, uint32_t timeout_ms) {
+    return detail::until_awaiter<std::decay_t<Pred>>(
+        *this, std::forward<Pred>(pred), _now_ms + timeout_ms
+    );
+}
+
+} // namespace maus_bus
+
+#endif
@@ -14,6 +14,7 @@ typedef enum {
     MAUS_BUS_TIMEOUT,
     MAUS_BUS_NOT_SUPPORTED,
     MAUS_BUS_NO_MEMORY,
+    MAUS_BUS_UNAVAILABLE, // The device is failing fast, so the bus wasn't touched.
 } maus_bus_err_t;
 
 #ifdef __cplusplus
@@ -0,0 +1,120 @@
+#ifndef __mt_accessory_common__maus_bus_frame_h
+#define __mt_accessory_common__maus_bus_frame_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "maus_bus.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MAUS_BUS_FRAME_GPIO_MAX
+#define MAUS_BUS_FRAME_GPIO_MAX 8 // PCA9554 expanders a frame can cover.
+#endif
+
+#ifndef MAUS_BUS_FRAME_TSCODE_MAX
+#define MAUS_BUS_FRAME_TSCODE_MAX 8 // TS-Code subaddresses that can be waiting at once.
+#endif
+
+#ifndef MAUS_BUS_FRAME_TSCODE_LEN
+#define MAUS_BUS_FRAME_TSCODE_LEN 8 // Longest TS-Code payload, not counting the subaddress.
+#endif
+
+/**
+ * @brief Frame scheduler configuration.
+ */
+typedef struct {
+    uint32_t period_ms; // Time between frames, e.g. 10 for 100Hz.
+    int measure;        // Time frames with the clock_us callback instead of estimating.
+} maus_bus_frame_config_t;
+
+typedef struct {
+    uint32_t frames;       // Frames emitted, including ones with nothing staged.
+    uint32_t transactions; // Bus writes issued by frames.
+    uint32_t superseded;   // Staged values replaced before they went out.
+    uint32_t unchanged;    // Expander writes skipped because the outputs already matched.
+    uint32_t missed;       // Frame slots that passed without a tick to emit them.
+    uint32_t overruns;     // Frames that took longer on the bus than one period.
+    uint32_t errors;       // Writes that failed. The value stays staged for the next frame.
+    uint32_t max_late_ms;  // Worst delay between a slot and its frame going out.
+    uint32_t last_bus_us;  // Bus time of the last frame.
+    uint32_t max_bus_us;   // Bus time of the longest frame.
+} maus_bus_frame_stats_t;
+
+/**
+ * @brief Starts the scheduler. Call after maus_bus_init. Anything staged before is dropped.
+ *
+ * @param config
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_frame_init(const maus_bus_frame_config_t* config);
+void maus_bus_frame_deinit(void);
+
+/**
+ * @brief Stages one pin of a PCA9554 for the next frame. Staging the same pin again before the
+ * frame goes out replaces the earlier value.
+ *
+ * @param address Expander address.
+ * @param gpio_num 0-7.
+ * @param level
+ * @return maus_bus_err_t MAUS_BUS_NO_MEMORY if the frame already covers
+ * MAUS_BUS_FRAME_GPIO_MAX other expanders.
+ */
+maus_bus_err_t
+maus_bus_frame_set_gpio(uint8_t address, uint8_t gpio_num, pca9554_gpio_level_t level);
+
+/**
+ * @brief Stages several pins of a PCA9554 at once.
+ *
+ * @param address Expander address.
+ * @param mask Pins to change.
+ * @param levels New levels, only the bits in mask are used.
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_frame_set_gpio_port(uint8_t address, uint8_t mask, uint8_t levels);
+
+/**
+ * @brief Stages a TS-Code command for the next frame. A later command to the same subaddress
+ * replaces this one before it goes out.
+ *
+ * @param subaddress TS-Code channel.
+ * @param data Payload, copied.
+ * @param len At most MAUS_BUS_FRAME_TSCODE_LEN.
+ * @return maus_bus_err_t MAUS_BUS_NO_MEMORY if MAUS_BUS_FRAME_TSCODE_MAX other subaddresses are
+ * still waiting to go out.
+ */
+maus_bus_err_t maus_bus_frame_tscode(uint8_t subaddress, const uint8_t* data, size_t len);
+
+/**
+ * @brief Forgets what the scheduler thinks an expander's outputs are. Frames only write pins that
+ * change, judged by the levels they wrote last, so call this after writing the expander some other
+ * way, e.g. through its maus_bus_gpio_driver_t. The next frame for it reads the outputs back first.
+ *
+ * @param address Expander address.
+ */
+void maus_bus_frame_invalidate_gpio(uint8_t address);
+
+/**
+ * @brief Emits the staged frame once its slot comes up. Call this at least once per period.
+ *
+ * Frames go out as one run of realtime writes: expanders in address order, then TS-Code
+ * commands in the order their channels were first staged since they last went out. Each expander
+ * costs at most one write, and none if its outputs wouldn't change.
+ *
+ * Slots are fixed to the first tick, so a late frame doesn't push the next one back. If a whole
+ * slot goes by without a tick, it counts as missed and its updates go out with the next frame.
+ *
+ * @param now_ms Monotonic time in milliseconds.
+ * @return int 1 if a frame went out, 0 otherwise.
+ */
+int maus_bus_frame_tick(uint32_t now_ms);
+
+void maus_bus_frame_get_stats(maus_bus_frame_stats_t* stats);
+void maus_bus_frame_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
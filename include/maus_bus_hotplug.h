@@ -0,0 +1,121 @@
+#ifndef __mt_accessory_common__maus_bus_hotplug_h
+#define __mt_accessory_common__maus_bus_hotplug_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "maus_bus.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    MAUS_BUS_EVENT_CONNECTED,      // Something started answering at this address.
+    MAUS_BUS_EVENT_DISCONNECTED,   // Something stopped answering at this address.
+    MAUS_BUS_EVENT_STATUS_CHANGED, // A registered device changed status without coming or going.
+} maus_bus_event_type_t;
+
+/**
+ * @brief Hotplug event. For registered devices, old_status and new_status hold the registry
+ * transition. Unregistered devices always report DISCONNECTED -> CONNECTED or the reverse.
+ */
+typedef struct {
+    maus_bus_event_type_t type;
+    uint8_t address[MAUS_BUS_ADDRESS_MAX_DEPTH + 1]; // Null-terminated, usable as an address.
+    maus_bus_status_t old_status;
+    maus_bus_status_t new_status;
+    int registered;
+} maus_bus_hotplug_event_t;
+
+/**
+ * @brief Hotplug pipeline configuration.
+ */
+typedef struct {
+    uint32_t debounce_ms; // Quiet time after the last edge before a burst is considered settled.
+    uint32_t max_hold_ms; // Rescan anyway if a burst keeps bouncing this long. 0 waits forever.
+    size_t queue_len;     // Events held before the oldest are dropped.
+} maus_bus_hotplug_config_t;
+
+typedef struct {
+    uint32_t edges;   // Edges reported through maus_bus_hotplug_edge.
+    uint32_t rescans; // Rescans actually run, at most one per burst.
+    uint32_t events;  // Events queued.
+    uint32_t dropped; // Events dropped because the queue was full.
+} maus_bus_hotplug_stats_t;
+
+/**
+ * @brief Sets up the event queue. Call after maus_bus_init.
+ *
+ * @param config
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_hotplug_init(const maus_bus_hotplug_config_t* config);
+void maus_bus_hotplug_deinit(void);
+
+/**
+ * @brief Reports a PIDET edge, or any other hint that something was plugged or unplugged.
+ *
+ * This only records the time, so it is cheap enough to call straight from an interrupt. No bus
+ * traffic happens until maus_bus_hotplug_tick decides the burst has settled.
+ *
+ * @param now_ms Monotonic time in milliseconds.
+ */
+void maus_bus_hotplug_edge(uint32_t now_ms);
+
+/**
+ * @brief Runs the pipeline. Call this periodically from your main loop or a task.
+ *
+ * When a burst of edges has been quiet for debounce_ms, one targeted rescan runs. It re-reads
+ * the EEPROM ID chips and probes registered devices, instead of walking the whole bus. Registered
+ * device status is updated and events are queued for every change.
+ *
+ * Scan results from earlier scans are freed by the rescan. New devices can be registered with
+ * maus_bus_register_device until the next one.
+ *
+ * @param now_ms Monotonic time in milliseconds.
+ * @return size_t Number of events queued by this tick.
+ */
+size_t maus_bus_hotplug_tick(uint32_t now_ms);
+
+/**
+ * @brief Pops the oldest event.
+ *
+ * @param event
+ * @return int 1 if an event was returned, 0 if the queue is empty.
+ */
+int maus_bus_hotplug_poll(maus_bus_hotplug_event_t* event);
+
+/**
+ * @brief Queues an event from outside the pipeline, e.g. from a liveness check.
+ *
+ * If the queue is full the oldest event is dropped, so the latest state is always kept.
+ *
+ * @param event
+ * @return maus_bus_err_t MAUS_BUS_FAIL if the pipeline isn't initialized.
+ */
+maus_bus_err_t maus_bus_hotplug_post(const maus_bus_hotplug_event_t* event);
+
+/**
+ * @brief Queues the event matching a status transition: CONNECTED or DISCONNECTED when the device
+ * came or went, STATUS_CHANGED otherwise.
+ *
+ * @param address
+ * @param old_status
+ * @param new_status
+ * @param registered
+ * @return maus_bus_err_t MAUS_BUS_FAIL if the pipeline isn't initialized.
+ */
+maus_bus_err_t maus_bus_hotplug_post_status(
+    maus_bus_address_t address,
+    maus_bus_status_t old_status,
+    maus_bus_status_t new_status,
+    int registered
+);
+
+void maus_bus_hotplug_get_stats(maus_bus_hotplug_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __mt_accessory_common__maus_bus_monitor_h
+#define __mt_accessory_common__maus_bus_monitor_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "maus_bus.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The check used for a device, picked as the cheapest one that still proves it's alive.
+ */
+typedef enum {
+    MAUS_BUS_CHECK_PROBE,    // Bare ACK probe, for devices we know nothing else about.
+    MAUS_BUS_CHECK_GUARD,    // Read the 0xCAFE guard from the ID EEPROM.
+    MAUS_BUS_CHECK_SC16_SPR, // Read the SC16IS740 scratch register, so the UART itself answers.
+} maus_bus_check_t;
+
+/**
+ * @brief Liveness monitor configuration.
+ */
+typedef struct {
+    uint32_t interval_ms;     // Target time between two checks of the same device.
+    uint16_t budget_permille; // Share of bus time checks may use, e.g. 20 for 2%.
+} maus_bus_monitor_config_t;
+
+typedef struct {
+    uint32_t checks;          // Checks run.
+    uint32_t failures;        // Checks that failed.
+    uint32_t deferred;        // Ticks where a check was due but the budget ran out.
+    uint64_t spent_us;        // Estimated bus time spent on checks.
+} maus_bus_monitor_stats_t;
+
+maus_bus_err_t maus_bus_monitor_init(const maus_bus_monitor_config_t* config);
+
+/**
+ * @brief Runs at most one check. Call this periodically from your main loop or a task.
+ *
+ * Checks are spread evenly over interval_ms, one device per slot, and bus time is metered with a
+ * token bucket that fills at budget_permille of real time. A check costs its estimated on-wire time
+ * at the clock its target is bound to. When the budget is exhausted the check
+ * waits, so the interval stretches rather than the bus getting busier.
+ *
+ * Status changes are written to the registry, and posted to the hotplug queue when it is running.
+ *
+ * @param now_ms Monotonic time in milliseconds.
+ * @return int 1 if a check ran, 0 otherwise.
+ */
+int maus_bus_monitor_tick(uint32_t now_ms);
+
+/**
+ * @brief Picks the check for a device.
+ *
+ * @param device
+ * @return maus_bus_check_t
+ */
+maus_bus_check_t maus_bus_monitor_check_for(const maus_bus_device_t* device);
+
+void maus_bus_monitor_get_stats(maus_bus_monitor_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef __mt_accessory_common__maus_bus_occupancy_h
+#define __mt_accessory_common__maus_bus_occupancy_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "maus_bus.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MAUS_BUS_OCCUPANCY_WINDOWS
+#define MAUS_BUS_OCCUPANCY_WINDOWS 8
+#endif
+
+/**
+ * @brief Who a transaction is billed to. Anything issued while a scan is running counts as SCAN,
+ * everything else goes by the driver that owns the address.
+ */
+typedef enum {
+    MAUS_BUS_CONSUMER_SCAN,    // Quick and full scans, including hotplug rescans.
+    MAUS_BUS_CONSUMER_SC16,    // SC16IS740 UART bridge.
+    MAUS_BUS_CONSUMER_PCA9554, // PCA9554/PCA9554A GPIO expanders.
+    MAUS_BUS_CONSUMER_TSCODE,  // TS-Code listener.
+    MAUS_BUS_CONSUMER_EEPROM,  // ID EEPROM reads outside of a scan.
+    MAUS_BUS_CONSUMER_OTHER,   // Anything else.
+    MAUS_BUS_CONSUMER_MAX,
+} maus_bus_consumer_t;
+
+/**
+ * @brief Transaction shapes, for estimating on-wire time.
+ */
+typedef enum {
+    MAUS_BUS_OP_PROBE, // Address byte only.
+    MAUS_BUS_OP_WRITE, // Address, subaddress, data.
+    MAUS_BUS_OP_READ,  // Address, subaddress, repeated start, address, data.
+} maus_bus_op_t;
+
+/**
+ * @brief Occupancy accounting configuration. Unless measuring, transactions are estimated at the
+ * clock their target is bound to, see maus_bus_target_clock_hz.
+ */
+typedef struct {
+    uint32_t window_ms; // Length of one accounting window.
+    int measure;        // Time transactions with the clock_us callback instead of estimating.
+} maus_bus_occupancy_config_t;
+
+typedef struct {
+    uint32_t transactions; // Times the bus was taken.
+    uint64_t bytes;        // Payload bytes moved, not counting address and subaddress.
+    uint64_t busy_us;      // Time spent on the wire.
+} maus_bus_occupancy_counter_t;
+
+/**
+ * @brief Utilization over the completed windows still held, MAUS_BUS_OCCUPANCY_WINDOWS at most.
+ */
+typedef struct {
+    uint32_t windows;              // Completed windows included.
+    uint64_t busy_us;              // Time the bus was occupied.
+    uint64_t idle_us;              // Time it was free.
+    uint16_t utilization_permille; // busy / (busy + idle).
+    uint16_t peak_permille;        // Busiest single window.
+} maus_bus_occupancy_summary_t;
+
+typedef struct {
+    uint8_t address;
+    maus_bus_occupancy_counter_t counter;
+} maus_bus_occupancy_top_t;
+
+/**
+ * @brief Starts accounting. Call after maus_bus_init. Counters start from zero.
+ *
+ * @param config
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_occupancy_init(const maus_bus_occupancy_config_t* config);
+void maus_bus_occupancy_deinit(void);
+
+/**
+ * @brief Closes the current window once window_ms has passed. Call this periodically; windows
+ * longer than intended just mean this wasn't called often enough.
+ *
+ * @param now_ms Monotonic time in milliseconds.
+ */
+void maus_bus_occupancy_tick(uint32_t now_ms);
+
+/**
+ * @brief Estimated on-wire time of one transaction, counting start/stop and the ACK on every byte.
+ *
+ * @param op
+ * @param len Payload bytes.
+ * @param bus_clock_hz
+ * @return uint32_t Microseconds, rounded up.
+ */
+uint32_t maus_bus_occupancy_estimate_us(maus_bus_op_t op, size_t len, uint32_t bus_clock_hz);
+
+void maus_bus_occupancy_get_summary(maus_bus_occupancy_summary_t* summary);
+
+/**
+ * @brief Totals for one consumer since init or the last reset.
+ *
+ * @param consumer
+ * @param counter
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t
+maus_bus_occupancy_get_consumer(maus_bus_consumer_t consumer, maus_bus_occupancy_counter_t* counter);
+
+/**
+ * @brief The addresses that used the most bus time since init or the last reset, busiest first.
+ *
+ * @param top Filled with up to max entries.
+ * @param max
+ * @return size_t Entries written.
+ */
+size_t maus_bus_occupancy_top(maus_bus_occupancy_top_t* top, size_t max);
+
+/**
+ * @brief Clears the per-consumer and per-address totals. Windows are kept.
+ */
+void maus_bus_occupancy_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,224 @@
+#ifndef __mt_accessory_common__maus_bus_regmap_hpp
+#define __mt_accessory_common__maus_bus_regmap_hpp
+
+/**
+ * Typed register maps for Maus-Bus chips. C++17, header-only.
+ *
+ * Chips describe their registers and bitfields as constexpr types. A single write() call can set
+ * any number of fields: fields in the same register are merged into one transaction. The plan for
+ * which transactions to issue is computed at compile time. Only the field values are handled at
+ * runtime.
+ *
+ *   maus_bus::device<sc16is740::chip> uart;
+ *   uart.write(
+ *       sc16is740::lcr::word_length(SC16_DATA_8),
+ *       sc16is740::lcr::parity(SC16_PARITY_NONE),
+ *       sc16is740::lcr::stop_bits(SC16_STOP_1)
+ *   );
+ *
+ * A chip is any type providing:
+ *
+ *   static constexpr uint8_t default_address;
+ *   static constexpr uint8_t subaddress(uint8_t index);
+ */
+
+#include "maus_bus.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+namespace maus_bus {
+
+/**
+ * @brief How a register may be accessed. Partial writes to a write-only register can't be
+ * read-modify-write, so fields left out of the write are sent as zero.
+ */
+enum class access {
+    read_write,
+    read_only,
+    write_only,
+};
+
+template <typename Chip, uint8_t Index, access Access = access::read_write>
+struct reg {
+    using chip = Chip;
+    static constexpr uint8_t index = Index;
+    static constexpr uint8_t subaddress = Chip::subaddress(Index);
+    static constexpr access mode = Access;
+};
+
+/**
+ * @brief One field's value, already shifted into place. Produced by calling a field.
+ */
+template <typename Field>
+struct assignment {
+    using field_type = Field;
+    uint8_t bits;
+};
+
+template <typename Reg, uint8_t Offset, uint8_t Width, typename T = uint8_t>
+struct field {
+    static_assert(Width > 0 && Offset + Width <= 8, "fields must fit in an 8-bit register");
+
+    using reg = Reg;
+    using value_type = T;
+
+    static constexpr uint8_t offset = Offset;
+    static constexpr uint8_t width = Width;
+    static constexpr uint8_t mask = (uint8_t)(((1u << Width) - 1u) << Offset);
+
+    constexpr assignment<field> operator()(T value) const {
+        return assignment<field>{ (uint8_t)(((unsigned)value << Offset) & mask) };
+    }
+
+    static constexpr T decode(uint8_t reg_value) {
+        return (T)((reg_value & mask) >> Offset);
+    }
+};
+
+namespace detail {
+
+/**
+ * @brief One register in an access plan, with every bit the write covers.
+ */
+struct step {
+    uint8_t index;
+    uint8_t subaddress;
+    uint8_t mask;
+    access mode;
+};
+
+template <size_t N>
+struct plan {
+    step steps[N];
+    size_t count;
+};
+
+/**
+ * @brief Builds the access plan for a set of fields: one step per distinct register, in the order
+ * the fields first name them. Chips with banked registers depend on that order.
+ */
+template <typename... Fields>
+constexpr plan<sizeof...(Fields)> make_plan() {
+    plan<sizeof...(Fields)> p{};
+    const step fields[] = {
+        { Fields::reg::index, Fields::reg::subaddress, Fields::mask, Fields::reg::mode }...
+    };
+
+    // Merge fields that land in the same register.
+    for (size_t i = 0; i < sizeof...(Fields); i++) {
+        size_t j = 0;
+        while (j < p.count && p.steps[j].index != fields[i].index)
+            j++;
+
+        if (j == p.count) {
+            p.steps[p.count++] = fields[i];
+        } else {
+            p.steps[j].mask |= fields[i].mask;
+        }
+    }
+
+    return p;
+}
+
+} // namespace detail
+
+/**
+ * @brief One chip on the bus, at a fixed address.
+ */
+template <typename Chip>
+class device {
+  public:
+    constexpr explicit device(uint8_t address = Chip::default_address) : _address(address) {}
+
+    constexpr uint8_t address() const {
+        return _address;
+    }
+
+    /**
+     * @brief Writes fields. Fields of one register become one transaction: a plain write if every
+     * bit is covered, otherwise a read-modify-write.
+     */
+    template <typename... Fields>
+    maus_bus_err_t write(assignment<Fields>... values) const {
+        return _write(false, values...);
+    }
+
+    /**
+     * @brief Like write, but bits not covered by the given fields are written as zero instead of
+     * being preserved. This never reads, so it is one transaction per register.
+     */
+    template <typename... Fields>
+    maus_bus_err_t overwrite(assignment<Fields>... values) const {
+        return _write(true, values...);
+    }
+
+    template <typename Field>
+    maus_bus_err_t read(Field, typename Field::value_type* value) const {
+        static_assert(std::is_same_v<typename Field::reg::chip, Chip>, "field belongs to another chip");
+        static_assert(Field::reg::mode != access::write_only, "register is write-only");
+
+        uint8_t raw = 0x00;
+        maus_bus_err_t err = maus_bus_read_byte(_address, Field::reg::subaddress, &raw);
+        if (err == MAUS_BUS_OK) *value = Field::decode(raw);
+        return err;
+    }
+
+    template <typename Reg>
+    maus_bus_err_t read_reg(uint8_t* value) const {
+        static_assert(std::is_same_v<typename Reg::chip, Chip>, "register belongs to another chip");
+        static_assert(Reg::mode != access::write_only, "register is write-only");
+        return maus_bus_read_byte(_address, Reg::subaddress, value);
+    }
+
+  private:
+    template <typename... Fields>
+    maus_bus_err_t _write(bool zero_fill, assignment<Fields>... values) const {
+        static_assert(sizeof...(Fields) > 0, "nothing to write");
+        static_assert(
+            (std::is_same_v<typename Fields::reg::chip, Chip> && ...),
+            "all fields must belong to this chip"
+        );
+        static_assert(
+            ((Fields::reg::mode != access::read_only) && ...), "can't write a read-only register"
+        );
+
+        constexpr auto plan = detail::make_plan<Fields...>();
+        const uint8_t indices[] = { Fields::reg::index... };
+        const uint8_t bits[] = { values.bits... };
+        uint8_t data[sizeof...(Fields)] = {};
+
+        for (size_t s = 0; s < plan.count; s++) {
+            for (size_t f = 0; f < sizeof...(Fields); f++) {
+                if (indices[f] == plan.steps[s].index) data[s] |= bits[f];
+            }
+        }
+
+        for (size_t s = 0; s < plan.count; s++) {
+            const detail::step& step = plan.steps[s];
+            maus_bus_err_t err = MAUS_BUS_OK;
+
+            if (step.mask == 0xFF || zero_fill || step.mode == access::write_only) {
+                err = maus_bus_write_byte(_address, step.subaddress, data[s]);
+            } else {
+                uint8_t current = 0x00;
+                err = maus_bus_read_byte(_address, step.subaddress, &current);
+                if (err == MAUS_BUS_OK) {
+                    err = maus_bus_write_byte(
+                        _address, step.subaddress, (uint8_t)((current & ~step.mask) | data[s])
+                    );
+                }
+            }
+
+            if (err != MAUS_BUS_OK) return err;
+        }
+
+        return MAUS_BUS_OK;
+    }
+
+    uint8_t _address;
+};
+
+} // namespace maus_bus
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef __mt_accessory_common__maus_bus_snapshot_h
+#define __mt_accessory_common__maus_bus_snapshot_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "maus_bus.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAUS_BUS_SNAPSHOT_MAGIC 0x5353424DUL // "MBSS"
+#define MAUS_BUS_SNAPSHOT_VERSION 1
+
+#ifndef MAUS_BUS_SNAPSHOT_MAX_DEVICES
+#define MAUS_BUS_SNAPSHOT_MAX_DEVICES MAUS_BUS_REGISTRY_MAX
+#endif
+
+#if MAUS_BUS_SNAPSHOT_MAX_DEVICES > 255
+#error "MAUS_BUS_SNAPSHOT_MAX_DEVICES must fit in maus_bus_snapshot_header_t.count"
+#endif
+
+/**
+ * @brief Driver bindings recorded with each device, so a changed binding is noticed on restore.
+ */
+typedef enum {
+    MAUS_BUS_BINDING_SC16 = 0x01,
+    MAUS_BUS_BINDING_TSCODE = 0x02,
+    MAUS_BUS_BINDING_GPIO = 0x04,
+} maus_bus_binding_t;
+
+/**
+ * @brief Snapshot header. The blob is this, followed by count entries. The CRC covers the entries.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t count;
+    uint16_t crc;
+} maus_bus_snapshot_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t address[MAUS_BUS_ADDRESS_MAX_DEPTH + 1];
+    uint8_t binding;
+    maus_bus_device_t device;
+} maus_bus_snapshot_entry_t;
+
+/**
+ * @brief Storage callback to persist a snapshot blob, e.g. to NVS or flash.
+ */
+typedef maus_bus_err_t (*maus_bus_snapshot_write_fn)(const uint8_t* data, size_t len, void* ptr);
+
+/**
+ * @brief Storage callback to load a snapshot blob. Set len to the number of bytes read.
+ */
+typedef maus_bus_err_t (*maus_bus_snapshot_read_fn
+)(uint8_t* data, size_t max_len, size_t* len, void* ptr);
+
+typedef struct {
+    size_t restored;  // Verified with one read and registered straight from the snapshot.
+    size_t rescanned; // Something else answered at a snapshot address, and was re-read.
+    size_t dropped;   // Nothing answered at a snapshot address any more.
+    size_t rebound;   // Restored, but bound to a different driver than when it was saved.
+    int full_scan;    // The snapshot was missing or invalid, so a full scan ran instead.
+} maus_bus_snapshot_result_t;
+
+/**
+ * @brief Serializes every registered device to a versioned blob and hands it to write.
+ *
+ * @param write
+ * @param ptr Passed through to write.
+ * @return maus_bus_err_t MAUS_BUS_NO_MEMORY if more than MAUS_BUS_SNAPSHOT_MAX_DEVICES are
+ * registered.
+ */
+maus_bus_err_t maus_bus_snapshot_save(maus_bus_snapshot_write_fn write, void* ptr);
+
+/**
+ * @brief Restores the registry from a saved snapshot, for a fast warm boot.
+ *
+ * Each entry is checked with one short read (the first 8 bytes of the ID EEPROM), or a probe for
+ * unidentified devices, and registered if it matches. Only mismatches cost more: if a different
+ * accessory answers at that address, its record is re-read and reported through cb for the
+ * application to register. If the snapshot can't be read or fails its checks, this falls back to
+ * maus_bus_scan_bus_full.
+ *
+ * Restored devices are reported through cb as well. Registering them again is harmless.
+ *
+ * Devices plugged in since the snapshot was saved are not looked for, the hotplug pipeline finds
+ * those.
+ *
+ * @param read
+ * @param ptr Passed through to read.
+ * @param cb Called like a scan callback for every device found.
+ * @param cb_ptr Passed through to cb.
+ * @param result Optional.
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_snapshot_restore(
+    maus_bus_snapshot_read_fn read,
+    void* ptr,
+    maus_bus_scan_callback_t cb,
+    void* cb_ptr,
+    maus_bus_snapshot_result_t* result
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,12 +3,39 @@
 
 maus_bus_err_t generic_tscode_tx(uint8_t *data, size_t length) {
     if (length > 1) {
-        maus_bus_write(0x69, data[0], data + 1, length - 1);
-    } else {
-        maus_bus_write(0x69, data[0], NULL, 0);
+        return maus_bus_write_fifo_prio(
+            MAUS_BUS_PRIORITY_REALTIME, TSCODE_ADDRESS, data[0], data + 1, length - 1
+        );
     }
 
-    return MAUS_BUS_OK;
+    return maus_bus_write_fifo_prio(MAUS_BUS_PRIORITY_REALTIME, TSCODE_ADDRESS, data[0], NULL, 0);
+}
+
+maus_bus_err_t generic_tscode_txv(const maus_bus_segment_t *segments, size_t count) {
+    maus_bus_segment_t payload[MAUS_BUS_SEGMENTS_MAX];
+    size_t idx = 0;
+
+    if (count > MAUS_BUS_SEGMENTS_MAX) return MAUS_BUS_NOT_SUPPORTED;
+
+    // Skip to the subaddress byte:
+    while (idx < count && segments[idx].len == 0)
+        idx++;
+
+    if (idx == count) return MAUS_BUS_FAIL;
+
+    uint8_t subaddress = segments[idx].data[0];
+
+    // Same segments, minus the subaddress byte. Only the descriptors are copied.
+    payload[0].data = segments[idx].data + 1;
+    payload[0].len = segments[idx].len - 1;
+
+    for (size_t i = idx + 1; i < count; i++) {
+        payload[i - idx] = segments[i];
+    }
+
+    return maus_bus_writev_fifo_prio(
+        MAUS_BUS_PRIORITY_REALTIME, TSCODE_ADDRESS, subaddress, payload, count - idx
+    );
 }
 
 maus_bus_err_t generic_tscode_rx(uint8_t *data, size_t *count, size_t max_length) {
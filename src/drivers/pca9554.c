@@ -1,25 +1,64 @@
 #include "drivers/pca9554.h"
+#include "maus_bus.h"
+
+// Pin changes are control signals, so they go out ahead of scans and bulk UART traffic.
+#define PCA9554_PRIORITY MAUS_BUS_PRIORITY_REALTIME
+
+static maus_bus_err_t _write_reg(uint8_t address, uint8_t reg, uint8_t value) {
+    return maus_bus_write_prio(PCA9554_PRIORITY, address, reg, &value, 1);
+}
+
+static maus_bus_err_t _read_reg(uint8_t address, uint8_t reg, uint8_t *value) {
+    return maus_bus_read_prio(PCA9554_PRIORITY, address, reg, value, 1);
+}
+
+static maus_bus_err_t _update_bit(uint8_t address, uint8_t reg, uint8_t gpio_num, int set) {
+    maus_bus_err_t err = MAUS_BUS_OK;
+
+    uint8_t tmp = 0x00;
+
+    if (gpio_num > 7) return MAUS_BUS_FAIL;
+
+    err = err || _read_reg(address, reg, &tmp);
+    if (err != MAUS_BUS_OK) return err;
+
+    tmp = set ? (tmp | (1 << gpio_num)) : (tmp & ~(1 << gpio_num));
+    err = err || _write_reg(address, reg, tmp);
+
+    return err;
+}
 
 maus_bus_err_t pca9554_set_gpio_level(uint8_t address, uint8_t gpio_num, pca9554_gpio_level_t level) {
-    return MAUS_BUS_OK;
+    return _update_bit(address, PCA9554_REG_OUTPUT, gpio_num, level == PCA9554_HIGH);
 }
 
 maus_bus_err_t pca9554_set_all_gpio_levels(uint8_t address, uint8_t gpio_levels) {
-    return MAUS_BUS_OK;
+    return _write_reg(address, PCA9554_REG_OUTPUT, gpio_levels);
 }
 
 maus_bus_err_t pca9554_set_gpio_mode(uint8_t address, uint8_t gpio_num, pca9554_gpio_mode_t mode) {
-    return MAUS_BUS_OK;
+    // A set bit in the configuration register makes the pin an input.
+    return _update_bit(address, PCA9554_REG_CONFIG, gpio_num, mode == PCA9554_INPUT);
 }
 
 maus_bus_err_t pca9554_set_all_gpio_modes(uint8_t address, uint8_t gpio_modes) {
-    return MAUS_BUS_OK;
+    return _write_reg(address, PCA9554_REG_CONFIG, gpio_modes);
 }
 
 maus_bus_err_t pca9554_get_gpio_level(uint8_t address, uint8_t gpio_num, pca9554_gpio_level_t *level) {
-    return MAUS_BUS_OK;
+    maus_bus_err_t err = MAUS_BUS_OK;
+
+    uint8_t tmp = 0x00;
+
+    if (gpio_num > 7 || level == NULL) return MAUS_BUS_FAIL;
+
+    err = err || _read_reg(address, PCA9554_REG_INPUT, &tmp);
+    if (err == MAUS_BUS_OK) *level = (tmp >> gpio_num) & 1 ? PCA9554_HIGH : PCA9554_LOW;
+
+    return err;
 }
 
 maus_bus_err_t pca9554_get_all_gpio_levels(uint8_t address, uint8_t *levels) {
-    return MAUS_BUS_OK;
-}
\ No newline at end of file
+    if (levels == NULL) return MAUS_BUS_FAIL;
+    return _read_reg(address, PCA9554_REG_INPUT, levels);
+}
@@ -3,57 +3,198 @@
 maus_bus_err_t sc16_init(sc16_baud_t baud, sc16_data_bits_t data_bits, sc16_parity_t parity, sc16_stop_bits_t stop) {
     maus_bus_err_t err = MAUS_BUS_OK;
 
-    err = err || sc16_set_baud_rate(baud);
-    err = err || sc16_set_format(data_bits, parity, stop);
-    err = err || sc16_enable_fifo();
+    if (err == MAUS_BUS_OK) err = sc16_set_baud_rate(baud);
+    if (err == MAUS_BUS_OK) err = sc16_set_format(data_bits, parity, stop);
+    if (err == MAUS_BUS_OK) err = sc16_enable_fifo();
 
     return err;
 }
 
-maus_bus_err_t sc16_set_baud_rate(sc16_baud_t baud) {
+static sc16_baud_config_t _baud_config = {
+    .divisor = 0,
+    .prescaler = 1,
+    .actual = 0,
+    .error_ppm = 0,
+};
+
+maus_bus_err_t sc16_calc_baud(sc16_baud_t baud, sc16_baud_config_t *config) {
+    static const uint8_t prescalers[] = { 1, 4 };
+    int found = 0;
+
+    if (baud == 0 || config == NULL) return MAUS_BUS_FAIL;
+
+    for (size_t i = 0; i < sizeof(prescalers); i++) {
+        uint32_t clock = SC16_CRYSTAL_FREQ / prescalers[i];
+        uint32_t divisor = (clock + (baud * 8)) / (baud * 16); // Rounded to nearest
+
+        if (divisor == 0 || divisor > 0xFFFF) continue;
+
+        uint32_t actual = clock / (divisor * 16);
+        uint32_t delta = actual > baud ? actual - baud : baud - actual;
+        uint32_t error_ppm = (uint32_t)(((uint64_t)delta * 1000000) / baud);
+
+        // Prefer the undivided clock, it only loses to /4 on a strictly better match.
+        if (!found || error_ppm < config->error_ppm) {
+            config->divisor = (uint16_t)divisor;
+            config->prescaler = prescalers[i];
+            config->actual = actual;
+            config->error_ppm = error_ppm;
+            found = 1;
+        }
+    }
+
+    if (!found) return MAUS_BUS_NOT_SUPPORTED;
+    if (config->error_ppm > SC16_BAUD_MAX_ERROR_PPM) return MAUS_BUS_NOT_SUPPORTED;
+    return MAUS_BUS_OK;
+}
+
+/**
+ * @brief Sets EFR[4], which unlocks MCR[7:5], TCR/TLR and the rest of the enhanced features.
+ * Leaves LCR as it found it.
+ */
+static maus_bus_err_t _enable_enhanced(uint8_t *efr) {
+    maus_bus_err_t err = MAUS_BUS_OK;
+
+    uint8_t tmp_lcr = 0x00;
+    uint8_t tmp_efr = 0x00;
+
+    if (err == MAUS_BUS_OK) err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_LCR << 3, &tmp_lcr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, SC16_LCR_ENHANCED);
+    if (err == MAUS_BUS_OK) err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_EFR << 3, &tmp_efr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_EFR << 3, tmp_efr | 0x10);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr);
+
+    if (efr != NULL) *efr = tmp_efr | 0x10;
+    return err;
+}
+
+maus_bus_err_t sc16_apply_baud(const sc16_baud_config_t *config) {
     maus_bus_err_t err = MAUS_BUS_OK;
 
     uint8_t tmp_lcr = 0x00;
     uint8_t tmp_mcr = 0x00;
 
-    uint16_t baud_divisor = 0xFF;
-    uint8_t prescaler = 1;
+    if (config == NULL || config->divisor == 0) return MAUS_BUS_FAIL;
+
+    if (err == MAUS_BUS_OK) err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_MCR << 3, &tmp_mcr);
+    if (err != MAUS_BUS_OK) return err;
+
+    // MCR[7] selects the /4 prescaler, and is only writable with enhanced functions on.
+    if (((tmp_mcr & 0x80) != 0) != (config->prescaler == 4)) {
+        if (err == MAUS_BUS_OK) err = _enable_enhanced(NULL);
+        tmp_mcr = config->prescaler == 4 ? (tmp_mcr | 0x80) : (tmp_mcr & 0x7F);
+        if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_MCR << 3, tmp_mcr);
+    }
+
+    // printf("Divisor: %d (%04x), prescaler: %d, baud: %d\n", config->divisor, config->divisor, config->prescaler, config->actual);
+
+    if (err == MAUS_BUS_OK) err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_LCR << 3, &tmp_lcr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr | 0x80);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_DLL << 3, (uint8_t) config->divisor);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_DLH << 3, (uint8_t) (config->divisor >> 8));
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr);
+
+    if (err == MAUS_BUS_OK) _baud_config = *config;
+    return err;
+}
+
+maus_bus_err_t sc16_set_baud_rate(sc16_baud_t baud) {
+    sc16_baud_config_t config;
+
+    maus_bus_err_t err = sc16_calc_baud(baud, &config);
+    if (err != MAUS_BUS_OK) return err;
+
+    return sc16_apply_baud(&config);
+}
+
+void sc16_get_baud_config(sc16_baud_config_t *config) {
+    if (config != NULL) *config = _baud_config;
+}
+
+maus_bus_err_t sc16_set_flow_control(uint8_t flags) {
+    maus_bus_err_t err = MAUS_BUS_OK;
 
-    err = err || maus_bus_read_byte(SC16_ADDRESS, SC16_REG_LCR << 3, &tmp_mcr);
+    uint8_t tmp_lcr = 0x00;
+    uint8_t tmp_mcr = 0x00;
+    uint8_t tmp_efr = 0x00;
+
+    if (err == MAUS_BUS_OK) err = _enable_enhanced(&tmp_efr);
+    if (err == MAUS_BUS_OK) err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_LCR << 3, &tmp_lcr);
     if (err != MAUS_BUS_OK) return err;
 
-    if (tmp_mcr & 0x80) {
-        prescaler = 4;
+    // XON1/XOFF1 live in the enhanced register set, next to EFR.
+    if (flags & SC16_FLOW_XON_XOFF) {
+        if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, SC16_LCR_ENHANCED);
+        if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_XON1 << 3, SC16_XON_CHAR);
+        if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_XOFF1 << 3, SC16_XOFF_CHAR);
+        if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr);
     }
 
-    baud_divisor = (SC16_CRYSTAL_FREQ / prescaler) / (baud * 16);
+    // TCR/TLR replace MSR/SPR while MCR[2] is set.
+    if (err == MAUS_BUS_OK) err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_MCR << 3, &tmp_mcr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_MCR << 3, tmp_mcr | 0x04);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(
+        SC16_ADDRESS,
+        SC16_REG_TCR << 3,
+        ((SC16_FLOW_RESUME_LEVEL / 4) << 4) | (SC16_FLOW_HALT_LEVEL / 4)
+    );
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(
+        SC16_ADDRESS,
+        SC16_REG_TLR << 3,
+        ((SC16_FIFO_TRIGGER_LEVEL / 4) << 4) | (SC16_FIFO_TRIGGER_LEVEL / 4)
+    );
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_MCR << 3, tmp_mcr & ~0x04);
 
-    // printf("Divisor: %d (%04x), prescaler: %d, baud: %d\n", baud_divisor, baud_divisor, prescaler, baud);
+    tmp_efr &= 0x30; // Keep enhanced enable and special character detect, drop old flow bits
+    if (flags & SC16_FLOW_CTS) tmp_efr |= 0x80;
+    if (flags & SC16_FLOW_RTS) tmp_efr |= 0x40;
+    if (flags & SC16_FLOW_XON_XOFF) tmp_efr |= 0x0A; // TX and RX both on XON1/XOFF1
 
-    err = err || maus_bus_read_byte(SC16_ADDRESS, SC16_REG_LCR << 3, &tmp_lcr);
-    err = err || maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr | 0x80);
-    err = err || maus_bus_write_byte(SC16_ADDRESS, SC16_REG_DLL << 3, (uint8_t) baud_divisor);
-    err = err || maus_bus_write_byte(SC16_ADDRESS, SC16_REG_DLH << 3, (uint8_t) (baud_divisor >> 8));
-    err = err || maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, SC16_LCR_ENHANCED);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_EFR << 3, tmp_efr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr);
 
     return err;
 }
 
+maus_bus_err_t sc16_set_mode(uint32_t baud, uint8_t data, uint8_t parity, uint8_t stop) {
+    if (data < 5 || data > 8) return MAUS_BUS_NOT_SUPPORTED;
+    if (stop < 1 || stop > 2) return MAUS_BUS_NOT_SUPPORTED;
+
+    switch (parity) {
+    case SC16_PARITY_NONE:
+    case SC16_PARITY_ODD:
+    case SC16_PARITY_EVEN:
+    case SC16_PARITY_FORCE_1:
+    case SC16_PARITY_FORCE_0:
+        break;
+    default:
+        return MAUS_BUS_NOT_SUPPORTED;
+    }
+
+    maus_bus_err_t err = sc16_set_baud_rate(baud);
+    if (err != MAUS_BUS_OK) return err;
+
+    return sc16_set_format(
+        (sc16_data_bits_t)(data - 5), (sc16_parity_t)parity, stop == 2 ? SC16_STOP_2 : SC16_STOP_1
+    );
+}
+
 maus_bus_err_t sc16_set_format(sc16_data_bits_t data_bits, sc16_parity_t parity, sc16_stop_bits_t stop) {
     maus_bus_err_t err = MAUS_BUS_OK;
 
     uint8_t tmp_lcr = 0x00;
 
-    err = err || maus_bus_read_byte(SC16_ADDRESS, SC16_REG_LCR << 3, &tmp_lcr);
+    if (err == MAUS_BUS_OK) err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_LCR << 3, &tmp_lcr);
     if (err != MAUS_BUS_OK) return err;
 
     tmp_lcr =
         (tmp_lcr & 0b11000000) | 
         ((parity & 0b111) << 3) |
-        ((data_bits & 0b1) << 2) | 
+        ((stop & 0b1) << 2) | 
         (data_bits & 0b11);
 
-    err = err || maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_LCR << 3, tmp_lcr);
 
     return err;
 }
@@ -63,7 +204,7 @@ maus_bus_err_t sc16_enable_fifo(void) {
 
     uint8_t tmp_fcr = 0b00000001;
 
-    err = err || maus_bus_write_byte(SC16_ADDRESS, SC16_REG_FCR << 3, tmp_fcr);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_FCR << 3, tmp_fcr);
 
     return err;
 }
@@ -71,26 +212,103 @@ maus_bus_err_t sc16_enable_fifo(void) {
 maus_bus_err_t sc16_disable_fifo(void) {
     maus_bus_err_t err = MAUS_BUS_OK;
 
-    err = err || maus_bus_write_byte(SC16_ADDRESS, SC16_REG_FCR << 3, 0x00);
+    if (err == MAUS_BUS_OK) err = maus_bus_write_byte(SC16_ADDRESS, SC16_REG_FCR << 3, 0x00);
 
     return err;
 }
 
-maus_bus_err_t sc16_tx(uint8_t *data, size_t length) {
+static maus_bus_err_t _tx_segments(const maus_bus_segment_t *segments, size_t count) {
     maus_bus_err_t err = MAUS_BUS_OK;
 
-    // todo - the thr/rhr are 64 byte fifos, so we should loop and poll LSR until
-    //        lsr[6] or lsr[5] is set.
-    err = err || maus_bus_write(SC16_ADDRESS, SC16_REG_THR << 3, data, length);
+    size_t length = 0;
+
+    if (count > MAUS_BUS_SEGMENTS_MAX) return MAUS_BUS_NOT_SUPPORTED;
+
+    for (size_t i = 0; i < count; i++)
+        length += segments[i].len;
+
+    // Long bursts go out as bulk, one chunk per transaction, so realtime traffic can run between
+    // chunks. THR is a FIFO, so every chunk goes to the same subaddress and none is retried.
+    maus_bus_priority_t priority =
+        length > MAUS_BUS_BULK_CHUNK_SIZE ? MAUS_BUS_PRIORITY_BULK : MAUS_BUS_PRIORITY_NORMAL;
+    size_t sent = 0;
+    size_t seg = 0;
+    size_t seg_offset = 0;
+    size_t polls = 0;
+
+    while (err == MAUS_BUS_OK && sent < length) {
+        uint8_t space = 0;
+
+        // Never write more than the TX FIFO has room for, or bytes are silently lost.
+        err = maus_bus_read_prio(priority, SC16_ADDRESS, SC16_REG_TXLVL << 3, &space, 1);
+        if (err != MAUS_BUS_OK) break;
+
+        if (space == 0) {
+            if (++polls > SC16_TX_POLL_LIMIT) return MAUS_BUS_TIMEOUT;
+            continue;
+        }
+
+        size_t n = length - sent;
+        if (n > MAUS_BUS_BULK_CHUNK_SIZE) n = MAUS_BUS_BULK_CHUNK_SIZE;
+        if (n > space) n = space;
+
+        // Slice the next n bytes out of the caller's segments. Only the descriptors are copied.
+        maus_bus_segment_t chunk[MAUS_BUS_SEGMENTS_MAX];
+        size_t used = 0;
+        size_t filled = 0;
+
+        while (filled < n) {
+            if (seg_offset == segments[seg].len) {
+                seg++;
+                seg_offset = 0;
+                continue;
+            }
+
+            size_t take = segments[seg].len - seg_offset;
+            if (take > n - filled) take = n - filled;
+
+            chunk[used].data = segments[seg].data + seg_offset;
+            chunk[used].len = take;
+            used++;
+
+            filled += take;
+            seg_offset += take;
+        }
+
+        err = maus_bus_writev_fifo_prio(priority, SC16_ADDRESS, SC16_REG_THR << 3, chunk, used);
+        sent += n;
+        polls = 0;
+    }
 
     return err;
 }
 
+maus_bus_err_t sc16_tx(uint8_t *data, size_t length) {
+    maus_bus_segment_t segment = { .data = data, .len = length };
+
+    return _tx_segments(&segment, 1);
+}
+
+maus_bus_err_t sc16_txv(const maus_bus_segment_t *segments, size_t count) {
+    return _tx_segments(segments, count);
+}
+
 maus_bus_err_t sc16_rx(uint8_t *data, size_t *count, size_t max_length) {
     maus_bus_err_t err = MAUS_BUS_OK;
 
-    // todo - we should read bytes from the fifo until lsr[0] is cleared or max-length reached
-    err = err || maus_bus_read(SC16_ADDRESS, SC16_REG_RHR << 3, data, max_length);
+    uint8_t level = 0;
+
+    if (count != NULL) *count = 0;
+
+    // Only read what's actually waiting, reading an empty RHR just returns junk.
+    err = maus_bus_read_byte(SC16_ADDRESS, SC16_REG_RXLVL << 3, &level);
+    if (err != MAUS_BUS_OK) return err;
+
+    size_t n = level < max_length ? level : max_length;
+    if (n == 0) return MAUS_BUS_OK;
+
+    err = maus_bus_read_fifo_prio(MAUS_BUS_PRIORITY_NORMAL, SC16_ADDRESS, SC16_REG_RHR << 3, data, n);
+    if (err == MAUS_BUS_OK && count != NULL) *count = n;
 
     return err;
 }
\ No newline at end of file
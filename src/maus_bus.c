@@ -6,31 +6,98 @@
 #include "drivers/generic_tscode.h"
 #include "drivers/pca9554.h"
 #include "drivers/sc16is740.h"
+#include "maus_bus_internal.h"
 
 static const uint8_t EEPROM_IDS[] = { 0x50, 0x69 };
 static const uint8_t IGNORE_IDS[] = { 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57 };
 
-static struct _device_scan_node {
-    maus_bus_address_t address;
+// Every device ID read from the bus lives in exactly one record. The scan list, the registry and
+// the application all point at it and hold a reference. The generation changes whenever a record
+// is freed or unregistered, so handles to it go stale instead of pointing at whatever reuses the
+// slot. References taken under any generation since allocation can still be released.
+static struct _device_record {
+    uint8_t address[MAUS_BUS_ADDRESS_MAX_DEPTH + 1];
     maus_bus_device_t device;
-    struct _device_scan_node* next;
-}* _scan_list = NULL;
+    uint16_t generation;
+    uint16_t first_generation; // Generation when allocated.
+    uint16_t refcount;
+} _records[MAUS_BUS_RECORD_MAX];
+
+static struct _device_record* _scan_list[MAUS_BUS_RECORD_MAX];
+static size_t _scan_count = 0;
 
 static struct _device_driver_node {
     maus_bus_driver_t* driver;
-    maus_bus_address_t address;
-    maus_bus_device_t device;
-    struct _device_driver_node* next;
-}* _driver_list = NULL;
+    struct _device_record* record;
+    maus_bus_status_t status;
+    maus_bus_profile_t profile;
+} _registry[MAUS_BUS_REGISTRY_MAX];
+
+// Registry indexes, one bit per slot. Kept up to date on register, unregister and status changes
+// so queries never have to look at devices that don't match.
+static maus_bus_device_set_t _registered = 0;
+static maus_bus_device_set_t _connected = 0;
+static maus_bus_device_set_t _feature_index[MAUS_BUS_FEATURE_CAPABILITY_BITS];
+
+_Static_assert(
+    MAUS_BUS_FEATURE_CAPABILITIES == (1UL << MAUS_BUS_FEATURE_CAPABILITY_BITS) - 1,
+    "capabilities must be the low feature_flags bits, one index per bit"
+);
+_Static_assert(
+    (MAUS_BUS_FEATURE_BUS_SPEED & MAUS_BUS_FEATURE_CAPABILITIES) == 0,
+    "bus_speed is a setting, not a capability, and must not be indexed"
+);
+
+static struct _product_type_index {
+    uint16_t product_type;
+    maus_bus_device_set_t slots;
+} _product_types[MAUS_BUS_REGISTRY_MAX];
+static size_t _product_type_count = 0;
 
 static maus_bus_config_t _config = {
     .read = NULL,
     .write = NULL,
     .probe = NULL,
+    .writev = NULL,
+    .readv = NULL,
+    .lock = NULL,
+    .unlock = NULL,
+    .clock_us = NULL,
+    .configure_target = NULL,
+    .delay_us = NULL,
+};
+
+static maus_bus_profile_t _default_profile = {
+    .speed = MAUS_BUS_SPEED_STANDARD,
+    .timeout_us = MAUS_BUS_DEFAULT_TIMEOUT_US,
+    .retries = MAUS_BUS_DEFAULT_RETRIES,
+    .backoff_us = MAUS_BUS_DEFAULT_BACKOFF_US,
+    .backoff_max_us = MAUS_BUS_DEFAULT_BACKOFF_MAX_US,
+    .fail_threshold = MAUS_BUS_DEFAULT_FAIL_THRESHOLD,
+    .cooldown_us = MAUS_BUS_DEFAULT_COOLDOWN_US,
 };
 
+// Per 7-bit address: which profile applies, and the fail-fast breaker. Several registered devices
+// can share a chip, so the profile is merged from all of them.
+static struct _target {
+    maus_bus_profile_t profile;
+    uint8_t bound;                     // Registered devices using this address. 0 means default.
+    uint8_t failures;                  // Failed transactions in a row.
+    uint8_t open;                      // Failing fast.
+    uint16_t rejected;                 // Calls turned away since opening.
+    uint32_t opened_us;
+} _targets[128];
+
+// What configure_target was last told, so it is only called when that changes.
+static int _configured_address = -1;
+static uint32_t _configured_clock_hz = 0;
+static uint32_t _configured_timeout_us = 0;
+
+static maus_bus_retry_stats_t _retry_stats;
+
 maus_bus_err_t maus_bus_init(maus_bus_config_t* config) {
     _config = *config;
+    _configured_address = -1;
 
     if (config->probe == NULL || config->read == NULL || config->write == NULL) {
         return MAUS_BUS_FAIL;
@@ -39,33 +106,794 @@ maus_bus_err_t maus_bus_init(maus_bus_config_t* config) {
     return MAUS_BUS_OK;
 }
 
+uint32_t maus_bus_now_us(void) {
+    if (_config.clock_us == NULL) return 0;
+    return _config.clock_us();
+}
+
+// Dispatch
+
+static maus_bus_priority_stats_t _priority_stats[MAUS_BUS_PRIORITY_MAX];
+
+/**
+ * @brief Takes the bus for one transaction (or one chunk of a bulk transfer), recording how long
+ * the caller had to queue for it. The counters are only updated with the bus held.
+ *
+ * @param priority
+ * @param starts Non-zero if this is the first time the call takes the bus, so it counts as a
+ * transaction.
+ */
+static maus_bus_err_t _acquire(maus_bus_priority_t priority, int starts) {
+    if (priority >= MAUS_BUS_PRIORITY_MAX) priority = MAUS_BUS_PRIORITY_NORMAL;
+
+    uint32_t start = maus_bus_now_us();
+
+    if (_config.lock != NULL) {
+        maus_bus_err_t err = _config.lock(priority);
+        if (err != MAUS_BUS_OK) return err;
+    }
+
+    uint32_t waited = maus_bus_now_us() - start;
+    maus_bus_priority_stats_t* stats = &_priority_stats[priority];
+
+    if (starts) stats->transactions++;
+    stats->chunks++;
+    stats->total_wait_us += waited;
+    if (waited > stats->max_wait_us) stats->max_wait_us = waited;
+
+    return MAUS_BUS_OK;
+}
+
+static void _release(void) {
+    if (_config.unlock != NULL) _config.unlock();
+}
+
+/**
+ * @brief One backend call: a probe, a plain read or write, or a vectored one if segments is set.
+ */
+struct _op {
+    maus_bus_op_t kind;
+    uint8_t address;
+    uint8_t subaddress;
+    uint8_t* data;
+    size_t len;
+    const maus_bus_segment_t* segments;
+    size_t count;
+    int unguarded; // One attempt, and the breaker neither blocks it nor hears about it.
+    int scan;      // Sent by a scan: unguarded too, and billed to the scan, not the device.
+    int fifo;      // Moves data through a FIFO register: never retried, chunks keep the subaddress.
+    int continued; // A later chunk of a call that was already counted as a transaction.
+};
+
+static uint32_t _occupancy_start(void) {
+    return maus_bus_occupancy_measuring() ? maus_bus_now_us() : 0;
+}
+
+static void _occupancy_end(const struct _op* op, uint32_t start) {
+    uint32_t measured = maus_bus_occupancy_measuring() ? maus_bus_now_us() - start : 0;
+    maus_bus_occupancy_record(op->address, op->kind, op->len, measured, op->scan);
+}
+
+static maus_bus_err_t _backend(const struct _op* op) {
+    maus_bus_err_t err = MAUS_BUS_FAIL;
+    uint32_t start = _occupancy_start();
+
+    switch (op->kind) {
+    case MAUS_BUS_OP_PROBE:
+        err = _config.probe(op->address);
+        break;
+
+    case MAUS_BUS_OP_WRITE:
+        err = op->segments != NULL
+                  ? _config.writev(op->address, op->subaddress, op->segments, op->count)
+                  : _config.write(op->address, op->subaddress, op->data, op->len);
+        break;
+
+    case MAUS_BUS_OP_READ:
+        err = op->segments != NULL
+                  ? _config.readv(op->address, op->subaddress, op->segments, op->count)
+                  : _config.read(op->address, op->subaddress, op->data, op->len);
+        break;
+    }
+
+    _occupancy_end(op, start);
+    return err;
+}
+
+static const maus_bus_profile_t* _profile_of(uint8_t address) {
+    const struct _target* target = &_targets[address & 0x7F];
+    return target->bound ? &target->profile : &_default_profile;
+}
+
+static maus_bus_err_t _configure_target(uint8_t address, const maus_bus_profile_t* profile) {
+    uint32_t clock_hz = maus_bus_speed_hz(profile->speed);
+
+    if (_config.configure_target == NULL) return MAUS_BUS_OK;
+
+    if (_configured_address == address && _configured_clock_hz == clock_hz &&
+        _configured_timeout_us == profile->timeout_us) {
+        return MAUS_BUS_OK;
+    }
+
+    maus_bus_err_t err = _config.configure_target(address, clock_hz, profile->timeout_us);
+    if (err != MAUS_BUS_OK) {
+        _configured_address = -1;
+        return err;
+    }
+
+    _configured_address = address;
+    _configured_clock_hz = clock_hz;
+    _configured_timeout_us = profile->timeout_us;
+
+    return MAUS_BUS_OK;
+}
+
+static int _is_retryable(maus_bus_err_t err) {
+    return err == MAUS_BUS_FAIL || err == MAUS_BUS_TIMEOUT;
+}
+
+/**
+ * @brief Whether a device that is failing fast gets one attempt to show it has recovered.
+ */
+static int _breaker_half_open(struct _target* target, const maus_bus_profile_t* profile) {
+    if (_config.clock_us != NULL) return maus_bus_now_us() - target->opened_us >= profile->cooldown_us;
+
+    // No clock, so count calls instead of time.
+    return ++target->rejected > profile->fail_threshold;
+}
+
+static void _breaker_update(
+    struct _target* target, const maus_bus_profile_t* profile, maus_bus_err_t err
+) {
+    if (err == MAUS_BUS_OK) {
+        target->failures = 0;
+        target->open = 0;
+        return;
+    }
+
+    if (!_is_retryable(err)) return;
+    if (err == MAUS_BUS_TIMEOUT) _retry_stats.timeouts++;
+    if (target->failures < UINT8_MAX) target->failures++;
+
+    if (profile->fail_threshold == 0 || target->failures < profile->fail_threshold) return;
+
+    if (!target->open) _retry_stats.opened++;
+    target->open = 1;
+    target->rejected = 0;
+    target->opened_us = maus_bus_now_us();
+}
+
+/**
+ * @brief Runs one backend call under the target's profile: configures the bus for it, retries
+ * failures with bounded exponential backoff, and fails fast while the device is known to be stuck.
+ * The bus is released while backing off.
+ *
+ * Profiles, breakers and the retry counters are shared by every caller, so they are only read and
+ * updated with the bus held.
+ */
+static maus_bus_err_t _dispatch(maus_bus_priority_t priority, const struct _op* op) {
+    struct _target* target = &_targets[op->address & 0x7F];
+    int guarded = op->kind != MAUS_BUS_OP_PROBE && !op->scan && !op->unguarded;
+    int attempts = 1;
+    uint32_t backoff_us = 0;
+    uint32_t backoff_max_us = 0;
+    maus_bus_err_t err = MAUS_BUS_OK;
+
+    for (int attempt = 0; attempt < attempts; attempt++) {
+        if (attempt > 0) {
+            if (_config.delay_us != NULL && backoff_us > 0) _config.delay_us(backoff_us);
+
+            backoff_us *= 2;
+            if (backoff_us > backoff_max_us) backoff_us = backoff_max_us;
+        }
+
+        err = _acquire(priority, attempt == 0 && !op->continued);
+        if (err != MAUS_BUS_OK) return err;
+
+        const maus_bus_profile_t* profile = _profile_of(op->address);
+
+        if (attempt == 0) {
+            if (guarded && target->open && !_breaker_half_open(target, profile)) {
+                _retry_stats.rejected++;
+                _release();
+                return MAUS_BUS_UNAVAILABLE;
+            }
+
+            // A device that's just being given another chance only gets the one. A FIFO access
+            // that failed partway may already have pushed or popped bytes, so repeating it would
+            // send them twice or lose them.
+            if (guarded && !target->open && !op->fifo) attempts += profile->retries;
+
+            backoff_us = profile->backoff_us;
+            backoff_max_us = profile->backoff_max_us;
+        } else {
+            _retry_stats.retries++;
+        }
+
+        err = _configure_target(op->address, profile);
+        if (err == MAUS_BUS_OK) err = _backend(op);
+
+        int last = !_is_retryable(err) || attempt + 1 == attempts;
+        if (last && guarded) _breaker_update(target, profile, err);
+
+        _release();
+        if (last) break;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Runs a read or write, splitting bulk transfers into chunks so the bus is released (and
+ * higher classes can get in) between them. Chunks advance the subaddress, like EEPROM sequential
+ * access does, unless they go to a FIFO.
+ */
+static maus_bus_err_t _transfer(maus_bus_priority_t priority, const struct _op* request) {
+    size_t chunk = priority == MAUS_BUS_PRIORITY_BULK ? MAUS_BUS_BULK_CHUNK_SIZE : request->len;
+    size_t offset = 0;
+
+    if (request->kind == MAUS_BUS_OP_READ ? _config.read == NULL : _config.write == NULL) {
+        return MAUS_BUS_FAIL;
+    }
+
+    do {
+        struct _op op = *request;
+
+        op.len = request->len - offset < chunk ? request->len - offset : chunk;
+        op.data = request->data == NULL ? NULL : request->data + offset;
+        if (!request->fifo) op.subaddress = (uint8_t)(request->subaddress + offset);
+        op.continued = offset > 0;
+
+        maus_bus_err_t err = _dispatch(priority, &op);
+        if (err != MAUS_BUS_OK) return err;
+        offset += op.len;
+    } while (offset < request->len);
+
+    return MAUS_BUS_OK;
+}
+
+maus_bus_err_t maus_bus_write_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_WRITE,
+        .address = address,
+        .subaddress = subaddress,
+        .data = data,
+        .len = len,
+    };
+
+    return _transfer(priority, &op);
+}
+
+maus_bus_err_t maus_bus_read_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_READ,
+        .address = address,
+        .subaddress = subaddress,
+        .data = data,
+        .len = len,
+    };
+
+    if (_config.read == NULL) return MAUS_BUS_FAIL;
+    memset(data, 0, len);
+    return _transfer(priority, &op);
+}
+
+maus_bus_err_t maus_bus_write_fifo_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_WRITE,
+        .address = address,
+        .subaddress = subaddress,
+        .data = data,
+        .len = len,
+        .fifo = 1,
+    };
+
+    return _transfer(priority, &op);
+}
+
+maus_bus_err_t maus_bus_read_fifo_prio(
+    maus_bus_priority_t priority, uint8_t address, uint8_t subaddress, uint8_t* data, size_t len
+) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_READ,
+        .address = address,
+        .subaddress = subaddress,
+        .data = data,
+        .len = len,
+        .fifo = 1,
+    };
+
+    if (_config.read == NULL) return MAUS_BUS_FAIL;
+    memset(data, 0, len);
+    return _transfer(priority, &op);
+}
+
 maus_bus_err_t maus_bus_write(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len) {
-    if (_config.write == NULL) return MAUS_BUS_FAIL;
-    return _config.write(address, subaddress, data, len);
+    return maus_bus_write_prio(MAUS_BUS_PRIORITY_NORMAL, address, subaddress, data, len);
 }
 
 maus_bus_err_t maus_bus_write_byte(uint8_t address, uint8_t subaddress, uint8_t data) {
     // printf("write_byte(%02x, %02x, %02x);\n", address, subaddress, data);
-    if (_config.write == NULL) return MAUS_BUS_FAIL;
     uint8_t tmp = data;
-    return _config.write(address, subaddress, &tmp, 1);
+    return maus_bus_write_prio(MAUS_BUS_PRIORITY_NORMAL, address, subaddress, &tmp, 1);
 }
 
 maus_bus_err_t maus_bus_write_str(uint8_t address, uint8_t subaddress, char* str) {
-    if (_config.write == NULL) return MAUS_BUS_FAIL;
-    return _config.write(address, subaddress, (uint8_t*)str, strlen(str));
+    return maus_bus_write_prio(
+        MAUS_BUS_PRIORITY_NORMAL, address, subaddress, (uint8_t*)str, strlen(str)
+    );
 }
 
 maus_bus_err_t maus_bus_read(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len) {
+    return maus_bus_read_prio(MAUS_BUS_PRIORITY_NORMAL, address, subaddress, data, len);
+}
+
+maus_bus_err_t maus_bus_read_byte(uint8_t address, uint8_t subaddress, uint8_t* data) {
+    return maus_bus_read_prio(MAUS_BUS_PRIORITY_NORMAL, address, subaddress, data, 1);
+}
+
+static maus_bus_err_t _probe(maus_bus_priority_t priority, uint8_t address, int scan) {
+    if (_config.probe == NULL) return MAUS_BUS_FAIL;
+
+    struct _op op = {
+        .kind = MAUS_BUS_OP_PROBE,
+        .address = address,
+        .scan = scan,
+    };
+
+    return _dispatch(priority, &op);
+}
+
+maus_bus_err_t maus_bus_probe(uint8_t address) {
+    return _probe(MAUS_BUS_PRIORITY_NORMAL, address, 0);
+}
+
+maus_bus_err_t
+maus_bus_read_unguarded(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_READ,
+        .address = address,
+        .subaddress = subaddress,
+        .data = data,
+        .len = len,
+        .unguarded = 1,
+    };
+
     if (_config.read == NULL) return MAUS_BUS_FAIL;
     memset(data, 0, len);
-    return _config.read(address, subaddress, data, len);
+    return _transfer(MAUS_BUS_PRIORITY_NORMAL, &op);
 }
 
-maus_bus_err_t maus_bus_read_byte(uint8_t address, uint8_t subaddress, uint8_t* data) {
+/**
+ * @brief Bulk read on behalf of a scan, see struct _op.
+ */
+static maus_bus_err_t _scan_read(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_READ,
+        .address = address,
+        .subaddress = subaddress,
+        .data = data,
+        .len = len,
+        .scan = 1,
+    };
+
     if (_config.read == NULL) return MAUS_BUS_FAIL;
-    *data = 0x00;
-    return _config.read(address, subaddress, data, 1);
+    memset(data, 0, len);
+    return _transfer(MAUS_BUS_PRIORITY_BULK, &op);
+}
+
+maus_bus_err_t maus_bus_get_priority_stats(
+    maus_bus_priority_t priority, maus_bus_priority_stats_t* stats
+) {
+    if (priority >= MAUS_BUS_PRIORITY_MAX || stats == NULL) return MAUS_BUS_FAIL;
+    *stats = _priority_stats[priority];
+    return MAUS_BUS_OK;
+}
+
+void maus_bus_reset_priority_stats(void) {
+    memset(_priority_stats, 0, sizeof(_priority_stats));
+}
+
+/**
+ * @brief Speeds that didn't come from maus_bus_speed_t fall back to standard mode, which every
+ * device can do. Anything else would merge as faster than it runs.
+ */
+static maus_bus_speed_t _clamp_speed(uint32_t speed) {
+    return speed <= MAUS_BUS_SPEED_FAST_PLUS ? (maus_bus_speed_t)speed : MAUS_BUS_SPEED_STANDARD;
+}
+
+uint32_t maus_bus_speed_hz(maus_bus_speed_t speed) {
+    switch (speed) {
+    case MAUS_BUS_SPEED_FAST:
+        return 400000;
+    case MAUS_BUS_SPEED_FAST_PLUS:
+        return 1000000;
+    default:
+        return 100000;
+    }
+}
+
+void maus_bus_get_default_profile(maus_bus_profile_t* profile) {
+    if (profile != NULL) *profile = _default_profile;
+}
+
+void maus_bus_set_default_profile(const maus_bus_profile_t* profile) {
+    if (profile == NULL) return;
+
+    _default_profile = *profile;
+    _default_profile.speed = _clamp_speed(profile->speed);
+}
+
+void maus_bus_get_retry_stats(maus_bus_retry_stats_t* stats) {
+    if (stats != NULL) *stats = _retry_stats;
+}
+
+void maus_bus_reset_retry_stats(void) {
+    memset(&_retry_stats, 0, sizeof(_retry_stats));
+}
+
+static size_t _segments_len(const maus_bus_segment_t* segments, size_t count, size_t* used) {
+    size_t len = 0;
+    *used = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (segments[i].len == 0) continue;
+        len += segments[i].len;
+        (*used)++;
+    }
+
+    return len;
+}
+
+static const maus_bus_segment_t*
+_first_segment(const maus_bus_segment_t* segments, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (segments[i].len > 0) return &segments[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Fills chunk with descriptors for the next len bytes of segments, starting at *seg and
+ * *offset and advancing them. Only the descriptors are copied, never the data.
+ *
+ * @return size_t Number of descriptors used, at most the number of non-empty segments.
+ */
+static size_t _slice_segments(
+    const maus_bus_segment_t* segments,
+    size_t* seg,
+    size_t* offset,
+    size_t len,
+    maus_bus_segment_t* chunk
+) {
+    size_t used = 0;
+
+    while (len > 0) {
+        if (*offset == segments[*seg].len) {
+            (*seg)++;
+            *offset = 0;
+            continue;
+        }
+
+        size_t take = segments[*seg].len - *offset;
+        if (take > len) take = len;
+
+        chunk[used].data = segments[*seg].data + *offset;
+        chunk[used].len = take;
+        used++;
+
+        len -= take;
+        *offset += take;
+    }
+
+    return used;
+}
+
+/**
+ * @brief Runs a vectored transfer on a backend that can gather or scatter. Bulk transfers are split
+ * into chunks just like _transfer does, by slicing the segments rather than copying them.
+ */
+static maus_bus_err_t _dispatchv(maus_bus_priority_t priority, const struct _op* request) {
+    size_t chunk = priority == MAUS_BUS_PRIORITY_BULK ? MAUS_BUS_BULK_CHUNK_SIZE : request->len;
+    size_t seg = 0;
+    size_t seg_offset = 0;
+    size_t offset = 0;
+
+    if (request->len <= chunk) return _dispatch(priority, request);
+
+    while (offset < request->len) {
+        maus_bus_segment_t slice[MAUS_BUS_SEGMENTS_MAX];
+        struct _op op = *request;
+
+        op.len = request->len - offset < chunk ? request->len - offset : chunk;
+        op.segments = slice;
+        op.count = _slice_segments(request->segments, &seg, &seg_offset, op.len, slice);
+        if (!request->fifo) op.subaddress = (uint8_t)(request->subaddress + offset);
+        op.continued = offset > 0;
+
+        maus_bus_err_t err = _dispatch(priority, &op);
+        if (err != MAUS_BUS_OK) return err;
+        offset += op.len;
+    }
+
+    return MAUS_BUS_OK;
+}
+
+/**
+ * @brief Runs a vectored read or write: straight through the backend if it can gather or scatter,
+ * otherwise through _transfer, staging the segments in a temporary buffer if there is more than
+ * one.
+ */
+static maus_bus_err_t _transferv(maus_bus_priority_t priority, const struct _op* request) {
+    int is_read = request->kind == MAUS_BUS_OP_READ;
+    struct _op op = *request;
+    size_t used = 0;
+
+    if (request->count > MAUS_BUS_SEGMENTS_MAX) return MAUS_BUS_NOT_SUPPORTED;
+
+    op.len = _segments_len(request->segments, request->count, &used);
+
+    if (is_read ? _config.readv != NULL : _config.writev != NULL) return _dispatchv(priority, &op);
+
+    op.segments = NULL;
+    op.count = 0;
+
+    if (used == 0) {
+        return is_read ? MAUS_BUS_OK : _transfer(priority, &op);
+    }
+
+    if (used == 1) {
+        op.data = _first_segment(request->segments, request->count)->data;
+        return _transfer(priority, &op);
+    }
+
+    // Backend can't gather or scatter, so this is the one copy we can't avoid:
+    uint8_t* buf = (uint8_t*)calloc(1, op.len);
+    if (buf == NULL) return MAUS_BUS_NO_MEMORY;
+
+    uint8_t* cursor = buf;
+    for (size_t i = 0; !is_read && i < request->count; i++) {
+        if (request->segments[i].len == 0) continue;
+        memcpy(cursor, request->segments[i].data, request->segments[i].len);
+        cursor += request->segments[i].len;
+    }
+
+    op.data = buf;
+    maus_bus_err_t err = _transfer(priority, &op);
+
+    cursor = buf;
+    for (size_t i = 0; is_read && err == MAUS_BUS_OK && i < request->count; i++) {
+        if (request->segments[i].len == 0) continue;
+        memcpy(request->segments[i].data, cursor, request->segments[i].len);
+        cursor += request->segments[i].len;
+    }
+
+    free(buf);
+    return err;
+}
+
+maus_bus_err_t maus_bus_writev_prio(
+    maus_bus_priority_t priority,
+    uint8_t address,
+    uint8_t subaddress,
+    const maus_bus_segment_t* segments,
+    size_t count
+) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_WRITE,
+        .address = address,
+        .subaddress = subaddress,
+        .segments = segments,
+        .count = count,
+    };
+
+    return _transferv(priority, &op);
+}
+
+maus_bus_err_t maus_bus_writev_fifo_prio(
+    maus_bus_priority_t priority,
+    uint8_t address,
+    uint8_t subaddress,
+    const maus_bus_segment_t* segments,
+    size_t count
+) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_WRITE,
+        .address = address,
+        .subaddress = subaddress,
+        .segments = segments,
+        .count = count,
+        .fifo = 1,
+    };
+
+    return _transferv(priority, &op);
+}
+
+maus_bus_err_t maus_bus_readv_prio(
+    maus_bus_priority_t priority,
+    uint8_t address,
+    uint8_t subaddress,
+    const maus_bus_segment_t* segments,
+    size_t count
+) {
+    struct _op op = {
+        .kind = MAUS_BUS_OP_READ,
+        .address = address,
+        .subaddress = subaddress,
+        .segments = segments,
+        .count = count,
+    };
+
+    if (count > MAUS_BUS_SEGMENTS_MAX) return MAUS_BUS_NOT_SUPPORTED;
+
+    for (size_t i = 0; i < count; i++) {
+        if (segments[i].len > 0) memset(segments[i].data, 0, segments[i].len);
+    }
+
+    return _transferv(priority, &op);
+}
+
+maus_bus_err_t maus_bus_writev(
+    uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count
+) {
+    return maus_bus_writev_prio(MAUS_BUS_PRIORITY_NORMAL, address, subaddress, segments, count);
+}
+
+maus_bus_err_t maus_bus_readv(
+    uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count
+) {
+    return maus_bus_readv_prio(MAUS_BUS_PRIORITY_NORMAL, address, subaddress, segments, count);
+}
+
+// Device Records
+
+static int _device_idx_by_address(maus_bus_address_t address) {
+    for (size_t i = 0; i < _scan_count; i++) {
+        if (maus_bus_addrcmp(address, _scan_list[i]->address)) return (int)i;
+    }
+
+    return -1;
+}
+
+const maus_bus_device_t* maus_bus_get_scan_item_by_address(maus_bus_address_t address) {
+    if (address == NULL) return NULL;
+
+    int idx = _device_idx_by_address(address);
+    return idx < 0 ? NULL : &_scan_list[idx]->device;
+}
+
+static struct _device_driver_node* _driver_node_by_address(maus_bus_address_t address);
+
+static maus_bus_handle_t _handle_of(const struct _device_record* record) {
+    return ((maus_bus_handle_t)record->generation << 16) | (maus_bus_handle_t)(record - _records);
+}
+
+static struct _device_record* _record_from_handle(maus_bus_handle_t handle) {
+    size_t idx = handle & 0xFFFF;
+
+    if (idx >= MAUS_BUS_RECORD_MAX) return NULL;
+
+    struct _device_record* record = &_records[idx];
+    if (record->refcount == 0 || record->generation != (uint16_t)(handle >> 16)) return NULL;
+
+    return record;
+}
+
+/**
+ * @brief Like _record_from_handle, but also accepts handles that went stale on unregister, as long
+ * as the record hasn't been freed since. Only for giving references back.
+ */
+static struct _device_record* _record_from_retained(maus_bus_handle_t handle) {
+    size_t idx = handle & 0xFFFF;
+    uint16_t generation = (uint16_t)(handle >> 16);
+
+    if (idx >= MAUS_BUS_RECORD_MAX || generation == 0) return NULL;
+
+    struct _device_record* record = &_records[idx];
+    if (record->refcount == 0) return NULL;
+
+    // Generations only count up while the record is live, so this is a range check with wrap.
+    uint16_t age = (uint16_t)(generation - record->first_generation);
+    if (age > (uint16_t)(record->generation - record->first_generation)) return NULL;
+
+    return record;
+}
+
+static void _record_retire_handles(struct _device_record* record) {
+    record->generation++;
+    if (record->generation == 0) record->generation = 1;
+}
+
+static struct _device_record*
+_record_alloc(maus_bus_address_t address, const maus_bus_device_t* device) {
+    size_t depth = maus_bus_get_address_depth(address);
+    if (depth > MAUS_BUS_ADDRESS_MAX_DEPTH) return NULL;
+
+    for (size_t i = 0; i < MAUS_BUS_RECORD_MAX; i++) {
+        struct _device_record* record = &_records[i];
+        if (record->refcount != 0) continue;
+
+        // Generation 0 is never handed out, so a zeroed handle is always invalid.
+        if (record->generation == 0) record->generation = 1;
+
+        memset(record->address, 0, sizeof(record->address));
+        memcpy(record->address, address, depth);
+        memcpy(&record->device, device, sizeof(maus_bus_device_t));
+        record->refcount = 1;
+        record->first_generation = record->generation;
+
+        return record;
+    }
+
+    return NULL;
+}
+
+static void _record_put(struct _device_record* record) {
+    if (record == NULL || record->refcount == 0) return;
+    if (--record->refcount > 0) return;
+
+    _record_retire_handles(record);
+}
+
+/**
+ * @brief Adds a device to the scan list. If the registry already holds an identical record for the
+ * address, the scan shares it instead of storing another copy.
+ */
+static struct _device_record* _scan_add(maus_bus_address_t address, const maus_bus_device_t* device) {
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    struct _device_record* record = NULL;
+
+    if (_scan_count >= MAUS_BUS_RECORD_MAX) return NULL;
+
+    if (node != NULL && memcmp(&node->record->device, device, sizeof(maus_bus_device_t)) == 0) {
+        record = node->record;
+        record->refcount++;
+    } else {
+        record = _record_alloc(address, device);
+        if (record == NULL) return NULL;
+    }
+
+    _scan_list[_scan_count++] = record;
+    return record;
+}
+
+maus_bus_handle_t maus_bus_device_handle(maus_bus_address_t address) {
+    if (address == NULL) return MAUS_BUS_HANDLE_INVALID;
+
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    if (node != NULL) return _handle_of(node->record);
+
+    int idx = _device_idx_by_address(address);
+    return idx < 0 ? MAUS_BUS_HANDLE_INVALID : _handle_of(_scan_list[idx]);
+}
+
+maus_bus_handle_t maus_bus_device_retain(maus_bus_handle_t handle) {
+    struct _device_record* record = _record_from_handle(handle);
+    if (record == NULL) return MAUS_BUS_HANDLE_INVALID;
+
+    record->refcount++;
+    return handle;
+}
+
+void maus_bus_device_release(maus_bus_handle_t handle) {
+    _record_put(_record_from_retained(handle));
+}
+
+const maus_bus_device_t* maus_bus_device_get(maus_bus_handle_t handle) {
+    struct _device_record* record = _record_from_handle(handle);
+    return record == NULL ? NULL : &record->device;
+}
+
+maus_bus_address_t maus_bus_device_address(maus_bus_handle_t handle) {
+    struct _device_record* record = _record_from_handle(handle);
+    return record == NULL ? NULL : record->address;
 }
 
 // Scan Functions
@@ -79,42 +907,26 @@ size_t maus_bus_scan_bus_quick(maus_bus_scan_callback_t cb, void* ptr) {
     for (size_t i = 0; i < sizeof(EEPROM_IDS); i++) {
         uint8_t address = EEPROM_IDS[i];
         uint16_t guard = 0x0000;
-        _config.read(address, 0x00, (uint8_t*)&guard, 2);
+        _scan_read(address, 0x00, (uint8_t*)&guard, 2);
 
         if (guard == 0xCAFE) {
-            struct _device_scan_node* node = malloc(sizeof(struct _device_scan_node));
-            if (node == NULL) return count;
+            uint8_t addr_path[] = { address, 0x00 };
+            maus_bus_device_t device;
 
-            maus_bus_address_t addr_path = (maus_bus_address_t)malloc(1 + 1);
-
-            if (addr_path != NULL) {
-                addr_path[0] = address;
-                addr_path[1] = 0x00;
-            }
-
-            node->address = addr_path;
-            node->next = NULL;
-
-            _config.read(address, 0x00, (uint8_t*)&node->device, sizeof(maus_bus_device_t));
+            _scan_read(address, 0x00, (uint8_t*)&device, sizeof(maus_bus_device_t));
 
             // what in tarnation
-            if (node->device.__guard != guard) return count;
+            if (device.__guard != guard) return count;
 
             // Clean up data:
-            node->device.vendor_name[23] = '\0';
-            node->device.product_name[23] = '\0';
-
-            if (_scan_list == NULL) {
-                _scan_list = node;
-            } else {
-                struct _device_scan_node* p = _scan_list;
-                while (p->next != NULL)
-                    p = p->next;
-                p->next = node;
-            }
+            device.vendor_name[23] = '\0';
+            device.product_name[23] = '\0';
+
+            struct _device_record* record = _scan_add(addr_path, &device);
+            if (record == NULL) return count;
 
             if (cb != NULL) {
-                (*cb)(&node->device, node->address, ptr);
+                (*cb)(&record->device, record->address, ptr);
             }
 
             count++;
@@ -124,6 +936,12 @@ size_t maus_bus_scan_bus_quick(maus_bus_scan_callback_t cb, void* ptr) {
     return count;
 }
 
+maus_bus_device_t*
+maus_bus_scan_add_device(maus_bus_address_t address, const maus_bus_device_t* device) {
+    struct _device_record* record = _scan_add(address, device);
+    return record == NULL ? NULL : &record->device;
+}
+
 int maus_bus_addrcmp(maus_bus_address_t a, maus_bus_address_t b) {
     size_t idx = 0;
 
@@ -138,13 +956,14 @@ int maus_bus_addrcmp(maus_bus_address_t a, maus_bus_address_t b) {
 
 size_t maus_bus_get_address_depth(maus_bus_address_t address) {
     size_t depth = 0;
-    while (address[depth++] != 0x00)
+    while (address[depth] != 0x00)
         depth++;
     return depth;
 }
 
 uint8_t maus_bus_get_final_address(maus_bus_address_t address) {
-    return address[maus_bus_get_address_depth(address)];
+    size_t depth = maus_bus_get_address_depth(address);
+    return depth > 0 ? address[depth - 1] : 0x00;
 }
 
 size_t maus_bus_addr2str(char* str, size_t max_len, maus_bus_address_t address) {
@@ -164,37 +983,6 @@ size_t maus_bus_addr2str(char* str, size_t max_len, maus_bus_address_t address)
     return len;
 }
 
-int _device_idx_by_address(maus_bus_address_t address) {
-    struct _device_scan_node* p = _scan_list;
-    int i = 0;
-
-    while (p != NULL) {
-        if (maus_bus_addrcmp(address, p->address)) {
-            return i;
-        }
-
-        p = p->next;
-        i++;
-    }
-
-    return -1;
-}
-
-maus_bus_device_t* maus_bus_get_scan_item_by_address(maus_bus_address_t address) {
-    if (address == NULL) return NULL;
-    struct _device_scan_node* p = _scan_list;
-
-    while (p != NULL) {
-        if (maus_bus_addrcmp(p->address, address)) {
-            return &p->device;
-        }
-
-        p = p->next;
-    }
-
-    return NULL;
-}
-
 int _address_is_ignored(uint8_t address) {
     for (size_t ign = 0; ign < sizeof(IGNORE_IDS); ign++) {
         if (IGNORE_IDS[ign] == address) return 1;
@@ -204,7 +992,6 @@ int _address_is_ignored(uint8_t address) {
 
 size_t maus_bus_scan_bus_full(maus_bus_scan_callback_t cb, void* ptr) {
     size_t count = maus_bus_scan_bus_quick(cb, ptr);
-    size_t addr_depth = 0;
 
     for (size_t i = 0; i < 127; i++) {
         uint8_t address = i;
@@ -213,7 +1000,7 @@ size_t maus_bus_scan_bus_full(maus_bus_scan_callback_t cb, void* ptr) {
         if (_device_idx_by_address(addr_tmp) != -1) continue;
         if (_address_is_ignored(address)) continue;
 
-        maus_bus_err_t err = _config.probe(address);
+        maus_bus_err_t err = _probe(MAUS_BUS_PRIORITY_BULK, address, 1);
 
         if (err != MAUS_BUS_OK) {
             continue;
@@ -223,50 +1010,29 @@ size_t maus_bus_scan_bus_full(maus_bus_scan_callback_t cb, void* ptr) {
         maus_bus_addr2str(addr_str, 20, addr_tmp);
 
         // Device can be added as an unknown:
-        struct _device_scan_node* node = malloc(sizeof(struct _device_scan_node));
-        if (node == NULL) return count;
+        maus_bus_device_t device;
 
-        maus_bus_address_t addr_path = (maus_bus_address_t)malloc(addr_depth + 2);
-
-        if (addr_path != NULL) {
-            memcpy(addr_path, addr_tmp, addr_depth + 2);
-        }
-
-        node->address = addr_path;
-        node->next = NULL;
-
-        memset(&node->device, 0x00, sizeof(node->device));
-        snprintf(
-            node->device.vendor_name,
-            MAUS_BUS_VENDOR_MAX_LENGTH,
-            "<Unknown - %d>",
-            node->device.vendor_id
-        );
+        memset(&device, 0x00, sizeof(device));
+        snprintf(device.vendor_name, MAUS_BUS_VENDOR_MAX_LENGTH, "<Unknown - %d>", device.vendor_id);
         snprintf(
-            node->device.product_name,
+            device.product_name,
             MAUS_BUS_PRODUCT_MAX_LENGTH,
             "<Unknown 0x%02X - %d>",
             address,
-            node->device.product_id
+            device.product_id
         );
 
         // Devices at this address SPECIFICALLY are TS-code listeners.
         if (address == 0x69) {
-            node->device.features.serial = 0;
-            node->device.features.tscode = 1;
+            device.features.serial = 0;
+            device.features.tscode = 1;
         }
 
-        if (_scan_list == NULL) {
-            _scan_list = node;
-        } else {
-            struct _device_scan_node* p = _scan_list;
-            while (p->next != NULL)
-                p = p->next;
-            p->next = node;
-        }
+        struct _device_record* record = _scan_add(addr_tmp, &device);
+        if (record == NULL) return count;
 
         if (cb != NULL) {
-            (*cb)(&node->device, node->address, ptr);
+            (*cb)(&record->device, record->address, ptr);
         }
 
         count++;
@@ -276,13 +1042,12 @@ size_t maus_bus_scan_bus_full(maus_bus_scan_callback_t cb, void* ptr) {
 }
 
 void maus_bus_free_device_scan(void) {
-    struct _device_scan_node* p = _scan_list;
-
-    while (p != NULL) {
-        _scan_list = p->next;
-        free(p);
-        p = _scan_list;
+    for (size_t i = 0; i < _scan_count; i++) {
+        _record_put(_scan_list[i]);
+        _scan_list[i] = NULL;
     }
+
+    _scan_count = 0;
 }
 
 maus_bus_driver_t* maus_bus_discover_driver(maus_bus_device_t* device) {
@@ -292,19 +1057,22 @@ maus_bus_driver_t* maus_bus_discover_driver(maus_bus_device_t* device) {
     // Enumerate Features
 
     if (device->features.serial) {
-        driver->uart = malloc(sizeof(maus_bus_uart_driver_t));
+        driver->uart = calloc(1, sizeof(maus_bus_uart_driver_t));
 
         if (driver->uart != NULL) {
-            sc16_init(9600, SC16_DATA_8, SC16_PARITY_NONE, SC16_STOP_1);
+            sc16_init(SC16_DEFAULT_BAUD, SC16_DATA_8, SC16_PARITY_NONE, SC16_STOP_1);
 
             driver->uart->transmit = &sc16_tx;
+            driver->uart->transmitv = &sc16_txv;
             driver->uart->receive = &sc16_rx;
+            driver->uart->set_mode = &sc16_set_mode;
         }
     } else if (device->features.tscode) {
-        driver->uart = malloc(sizeof(maus_bus_uart_driver_t));
+        driver->uart = calloc(1, sizeof(maus_bus_uart_driver_t));
 
         if (driver->uart != NULL) {
             driver->uart->transmit = &generic_tscode_tx;
+            driver->uart->transmitv = &generic_tscode_txv;
             driver->uart->receive = &generic_tscode_rx;
         }
     }
@@ -313,6 +1081,7 @@ maus_bus_driver_t* maus_bus_discover_driver(maus_bus_device_t* device) {
         driver->gpio = malloc(sizeof(maus_bus_gpio_driver_t));
 
         if (driver->gpio != NULL) {
+            driver->gpio->address = PCA9554_ADDRESS;
             driver->gpio->mode = &pca9554_set_gpio_mode;
             driver->gpio->set = &pca9554_set_gpio_level;
             driver->gpio->get = &pca9554_get_gpio_level;
@@ -322,54 +1091,364 @@ maus_bus_driver_t* maus_bus_discover_driver(maus_bus_device_t* device) {
     return driver;
 }
 
-maus_bus_err_t maus_bus_register_device(maus_bus_address_t address) {
-    maus_bus_device_t* scan_item = maus_bus_get_scan_item_by_address(address);
-    if (scan_item == NULL) return MAUS_BUS_FAIL;
+static int _slot_of(const struct _device_driver_node* node) {
+    return (int)(node - _registry);
+}
 
-    maus_bus_driver_t* driver = maus_bus_discover_driver(scan_item);
-    if (driver == NULL) return MAUS_BUS_NOT_SUPPORTED;
+static struct _device_driver_node* _driver_node_by_address(maus_bus_address_t address) {
+    maus_bus_device_set_t set = _registered;
 
-    struct _device_driver_node* node =
-        (struct _device_driver_node*)malloc(sizeof(struct _device_driver_node));
-    if (node == NULL) goto error;
+    while (set != 0) {
+        int slot = __builtin_ctz(set);
+        set &= set - 1;
 
-    // This is duplicating a shallow copy of the device. It doesn't have pointers, does it?
-    memcpy(&node->device, scan_item, sizeof(maus_bus_device_t));
+        if (maus_bus_addrcmp(_registry[slot].record->address, address)) return &_registry[slot];
+    }
 
-    node->address = malloc(maus_bus_get_address_depth(address));
-    if (node->address == NULL) goto error;
+    return NULL;
+}
 
-    memcpy(node->address, address, maus_bus_get_address_depth(address));
+static struct _product_type_index* _product_type_entry(uint16_t product_type) {
+    for (size_t i = 0; i < _product_type_count; i++) {
+        if (_product_types[i].product_type == product_type) return &_product_types[i];
+    }
 
-    node->driver = driver;
-    node->next = NULL;
+    return NULL;
+}
 
-    struct _device_driver_node* ptr = _driver_list;
+static void _index_add(struct _device_driver_node* node) {
+    maus_bus_device_set_t bit = (maus_bus_device_set_t)1 << _slot_of(node);
+    uint32_t flags = node->record->device.feature_flags & MAUS_BUS_FEATURE_CAPABILITIES;
 
-    if (ptr == NULL) {
-        _driver_list = node;
-        return MAUS_BUS_OK;
+    _registered |= bit;
+    if (node->status == MAUS_BUS_STATUS_CONNECTED) _connected |= bit;
+
+    for (int f = 0; f < MAUS_BUS_FEATURE_CAPABILITY_BITS; f++) {
+        if (flags & (1UL << f)) _feature_index[f] |= bit;
+    }
+
+    // There can't be more distinct types than slots, so this never runs out.
+    struct _product_type_index* entry = _product_type_entry(node->record->device.product_type);
+
+    if (entry == NULL) {
+        entry = &_product_types[_product_type_count++];
+        entry->product_type = node->record->device.product_type;
+        entry->slots = 0;
     }
 
-    while (ptr->next != NULL)
-        ptr = ptr->next;
-    ptr->next = node;
+    entry->slots |= bit;
+}
+
+static void _index_remove(struct _device_driver_node* node) {
+    maus_bus_device_set_t bit = (maus_bus_device_set_t)1 << _slot_of(node);
+
+    _registered &= ~bit;
+    _connected &= ~bit;
+
+    for (int f = 0; f < MAUS_BUS_FEATURE_CAPABILITY_BITS; f++)
+        _feature_index[f] &= ~bit;
+
+    struct _product_type_index* entry = _product_type_entry(node->record->device.product_type);
+    if (entry == NULL) return;
+
+    entry->slots &= ~bit;
+
+    if (entry->slots == 0) {
+        *entry = _product_types[--_product_type_count];
+    }
+}
+
+/**
+ * @brief Addresses a registered device's traffic actually goes to: its own, plus the chips its
+ * drivers talk to.
+ */
+static size_t _node_targets(const struct _device_driver_node* node, uint8_t* targets) {
+    size_t count = 0;
+
+    targets[count++] = maus_bus_get_final_address(node->record->address);
+
+    if (node->driver->uart != NULL && node->driver->uart->transmit == &sc16_tx) {
+        targets[count++] = SC16_ADDRESS;
+    } else if (node->driver->uart != NULL && node->driver->uart->transmit == &generic_tscode_tx) {
+        targets[count++] = TSCODE_ADDRESS;
+    }
 
+    if (node->driver->gpio != NULL) targets[count++] = node->driver->gpio->address;
+
+    return count;
+}
+
+static int _node_uses_target(const struct _device_driver_node* node, uint8_t address) {
+    uint8_t targets[3];
+    size_t count = _node_targets(node, targets);
+
+    for (size_t i = 0; i < count; i++) {
+        if ((targets[i] & 0x7F) == (address & 0x7F)) return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Speed for a newly registered device: whatever its EEPROM declares, otherwise the slowest
+ * of the chips its drivers bind to.
+ */
+static maus_bus_speed_t _default_speed(const struct _device_driver_node* node) {
+    const maus_bus_device_t* device = &node->record->device;
+
+    // Stored as speed + 1, so 0 can mean the EEPROM doesn't say.
+    if (device->features.bus_speed != 0) return _clamp_speed(device->features.bus_speed - 1);
+
+    // SC16IS740 and PCA9554 both do fast mode. The TS-Code listener makes no promises, and nor
+    // does a device we know nothing about.
+    if (node->driver->uart == NULL && node->driver->gpio == NULL) return MAUS_BUS_SPEED_STANDARD;
+    if (node->driver->uart != NULL && node->driver->uart->transmit != &sc16_tx) {
+        return MAUS_BUS_SPEED_STANDARD;
+    }
+
+    return MAUS_BUS_SPEED_FAST;
+}
+
+/**
+ * @brief Folds one device's profile into a shared chip's. The chip gets whatever every device on it
+ * can live with: the slowest clock and longest timeout, the fewest retries with the gentlest
+ * backoff, and the breaker that trips first and stays open longest.
+ */
+static void _merge_profile(maus_bus_profile_t* into, const maus_bus_profile_t* from) {
+    if (from->speed < into->speed) into->speed = from->speed;
+    if (from->timeout_us > into->timeout_us) into->timeout_us = from->timeout_us;
+    if (from->retries < into->retries) into->retries = from->retries;
+    if (from->backoff_us > into->backoff_us) into->backoff_us = from->backoff_us;
+    if (from->backoff_max_us > into->backoff_max_us) into->backoff_max_us = from->backoff_max_us;
+    if (from->cooldown_us > into->cooldown_us) into->cooldown_us = from->cooldown_us;
+
+    if (from->fail_threshold != 0 &&
+        (into->fail_threshold == 0 || from->fail_threshold < into->fail_threshold)) {
+        into->fail_threshold = from->fail_threshold;
+    }
+}
+
+/**
+ * @brief Recomputes the profile of one address from every registered device that uses it.
+ */
+static void _rebind_target(uint8_t address) {
+    struct _target* target = &_targets[address & 0x7F];
+    maus_bus_device_set_t set = _registered;
+
+    target->bound = 0;
+
+    while (set != 0) {
+        const struct _device_driver_node* node = &_registry[__builtin_ctz(set)];
+        set &= set - 1;
+
+        if (!_node_uses_target(node, address)) continue;
+
+        if (target->bound == 0) {
+            target->profile = node->profile;
+        } else {
+            _merge_profile(&target->profile, &node->profile);
+        }
+
+        if (target->bound < UINT8_MAX) target->bound++;
+    }
+
+    target->failures = 0;
+    target->open = 0;
+}
+
+/**
+ * @brief Rebinds every address a device uses. Call after it was added to or removed from
+ * _registered, or its profile changed.
+ */
+static void _bind_profile(const struct _device_driver_node* node) {
+    uint8_t targets[3];
+    size_t count = _node_targets(node, targets);
+
+    for (size_t i = 0; i < count; i++)
+        _rebind_target(targets[i]);
+
+    // The target may be the one last configured, with different settings now.
+    _configured_address = -1;
+}
+
+maus_bus_err_t maus_bus_register_device(maus_bus_address_t address) {
+    int scan_idx = address == NULL ? -1 : _device_idx_by_address(address);
+    if (scan_idx < 0) return MAUS_BUS_FAIL;
+
+    // Already registered, e.g. restored from a snapshot and then seen by the app's scan callback.
+    if (_driver_node_by_address(address) != NULL) return MAUS_BUS_OK;
+
+    maus_bus_device_set_t free_slots = ~_registered;
+#if MAUS_BUS_REGISTRY_MAX < 32
+    free_slots &= ((maus_bus_device_set_t)1 << MAUS_BUS_REGISTRY_MAX) - 1;
+#endif
+    if (free_slots == 0) return MAUS_BUS_NO_MEMORY;
+
+    struct _device_driver_node* node = &_registry[__builtin_ctz(free_slots)];
+
+    struct _device_record* record = _scan_list[scan_idx];
+
+    node->driver = maus_bus_discover_driver(&record->device);
+    if (node->driver == NULL) return MAUS_BUS_NOT_SUPPORTED;
+
+    // The registry shares the scan's record, so it outlives maus_bus_free_device_scan.
+    record->refcount++;
+    node->record = record;
+    node->status = MAUS_BUS_STATUS_CONNECTED;
+
+    node->profile = _default_profile;
+    node->profile.speed = _default_speed(node);
+
+    _index_add(node);
+    _bind_profile(node);
     return MAUS_BUS_OK;
+}
+
+void maus_bus_free_driver(maus_bus_driver_t* driver) {
+    if (driver == NULL) return;
+
+    free(driver->uart);
+    free(driver->gpio);
+    free(driver);
+}
+
+maus_bus_err_t maus_bus_unregister_device(maus_bus_address_t address) {
+    if (address == NULL) return MAUS_BUS_FAIL;
+
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    if (node == NULL) return MAUS_BUS_FAIL;
+
+    // Out of the index first, so the shared chips fall back to whoever else still uses them.
+    _index_remove(node);
+    _bind_profile(node);
+
+    // Handles the application still holds now read as stale, but the record itself stays valid
+    // until the last of them is released. The scan list may still share it, and hands out a fresh
+    // handle if the device is registered again.
+    _record_retire_handles(node->record);
+    _record_put(node->record);
+
+    maus_bus_free_driver(node->driver);
+    memset(node, 0, sizeof(*node));
 
-error:
-    free(node->address);
-    free(node);
-    return MAUS_BUS_NO_MEMORY;
+    return MAUS_BUS_OK;
 }
 
 maus_bus_err_t maus_bus_enumerate_devices(maus_bus_enumeration_callback_t cb, void* ptr) {
-    struct _device_driver_node* node = _driver_list;
+    return maus_bus_enumerate_set(_registered, cb, ptr);
+}
+
+maus_bus_err_t
+maus_bus_enumerate_set(maus_bus_device_set_t set, maus_bus_enumeration_callback_t cb, void* ptr) {
+    if (cb == NULL) return MAUS_BUS_FAIL;
+
+    // Slots can be unregistered from inside the callback, so re-check each one before using it.
+    set &= _registered;
+
+    while (set != 0) {
+        int slot = __builtin_ctz(set);
+        set &= set - 1;
+
+        if (!(_registered & ((maus_bus_device_set_t)1 << slot))) continue;
+
+        struct _device_driver_node* node = &_registry[slot];
+        cb(node->driver, &node->record->device, node->record->address, ptr);
+    }
+
+    return MAUS_BUS_OK;
+}
+
+maus_bus_device_set_t maus_bus_query_features(uint32_t feature_flags) {
+    maus_bus_device_set_t set = _registered;
+
+    if (feature_flags & ~MAUS_BUS_FEATURE_CAPABILITIES) return 0;
+
+    for (int f = 0; f < MAUS_BUS_FEATURE_CAPABILITY_BITS; f++) {
+        if (feature_flags & (1UL << f)) set &= _feature_index[f];
+    }
+
+    return set;
+}
+
+maus_bus_device_set_t maus_bus_query_product_type(uint16_t product_type) {
+    struct _product_type_index* entry = _product_type_entry(product_type);
+    return entry == NULL ? 0 : entry->slots;
+}
+
+maus_bus_device_set_t maus_bus_query_connected(void) {
+    return _connected;
+}
+
+size_t maus_bus_device_set_count(maus_bus_device_set_t set) {
+    return (size_t)__builtin_popcount(set);
+}
+
+uint32_t maus_bus_target_clock_hz(uint8_t address) {
+    return maus_bus_speed_hz(_profile_of(address)->speed);
+}
 
-    while (node != NULL) {
-        cb(node->driver, &node->device, node->address, ptr);
-        node = node->next;
+maus_bus_err_t maus_bus_get_device_profile(maus_bus_address_t address, maus_bus_profile_t* profile) {
+    if (address == NULL || profile == NULL) return MAUS_BUS_FAIL;
+
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    if (node == NULL) return MAUS_BUS_FAIL;
+
+    *profile = node->profile;
+    return MAUS_BUS_OK;
+}
+
+maus_bus_err_t
+maus_bus_set_device_profile(maus_bus_address_t address, const maus_bus_profile_t* profile) {
+    if (address == NULL || profile == NULL) return MAUS_BUS_FAIL;
+
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    if (node == NULL) return MAUS_BUS_FAIL;
+
+    node->profile = *profile;
+    node->profile.speed = _clamp_speed(profile->speed);
+    _bind_profile(node);
+    return MAUS_BUS_OK;
+}
+
+maus_bus_err_t maus_bus_set_gpio_address(maus_bus_address_t address, uint8_t expander) {
+    if (address == NULL) return MAUS_BUS_FAIL;
+
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    if (node == NULL) return MAUS_BUS_FAIL;
+    if (node->driver->gpio == NULL) return MAUS_BUS_NOT_SUPPORTED;
+
+    uint8_t previous = node->driver->gpio->address;
+    node->driver->gpio->address = expander & 0x7F;
+
+    _rebind_target(previous);
+    _bind_profile(node);
+    return MAUS_BUS_OK;
+}
+
+maus_bus_err_t maus_bus_get_device_status(maus_bus_address_t address, maus_bus_status_t* status) {
+    if (address == NULL || status == NULL) return MAUS_BUS_FAIL;
+
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    if (node == NULL) return MAUS_BUS_FAIL;
+
+    *status = node->status;
+    return MAUS_BUS_OK;
+}
+
+maus_bus_err_t maus_bus_set_device_status(maus_bus_address_t address, maus_bus_status_t status) {
+    if (address == NULL) return MAUS_BUS_FAIL;
+
+    struct _device_driver_node* node = _driver_node_by_address(address);
+    if (node == NULL) return MAUS_BUS_FAIL;
+
+    maus_bus_device_set_t bit = (maus_bus_device_set_t)1 << _slot_of(node);
+
+    node->status = status;
+    if (status == MAUS_BUS_STATUS_CONNECTED) {
+        _connected |= bit;
+    } else {
+        _connected &= ~bit;
     }
 
     return MAUS_BUS_OK;
-}
\ No newline at end of file
+}
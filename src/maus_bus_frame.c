@@ -0,0 +1,255 @@
+#include "maus_bus_frame.h"
+#include "maus_bus_occupancy.h"
+#include <string.h>
+
+#include "drivers/generic_tscode.h"
+#include "drivers/pca9554.h"
+
+static maus_bus_frame_config_t _config = {
+    .period_ms = 0,
+    .measure = 0,
+};
+
+static int _initialized = 0;
+static int _started = 0;
+static uint32_t _next_ms = 0;
+
+static maus_bus_frame_stats_t _stats;
+
+// Expanders keep a copy of their output register, so a frame only ever writes it and never
+// has to read it back first. Kept sorted by address.
+static struct _gpio {
+    uint8_t address;
+    uint8_t known;  // output holds what the expander has.
+    uint8_t output; // Last levels written.
+    uint8_t mask;   // Pins staged for the next frame.
+    uint8_t levels;
+} _gpios[MAUS_BUS_FRAME_GPIO_MAX];
+
+static size_t _gpio_count = 0;
+
+// TS-Code commands waiting to go out, in the order their channels were first staged. A slot is
+// given back once its command has been sent.
+static struct _tscode {
+    uint8_t subaddress;
+    uint8_t pending;
+    uint8_t len;
+    uint8_t data[MAUS_BUS_FRAME_TSCODE_LEN];
+} _tscodes[MAUS_BUS_FRAME_TSCODE_MAX];
+
+static size_t _tscode_count = 0;
+
+maus_bus_err_t maus_bus_frame_init(const maus_bus_frame_config_t* config) {
+    if (config == NULL || config->period_ms == 0) return MAUS_BUS_FAIL;
+
+    maus_bus_frame_deinit();
+
+    _config = *config;
+
+    _initialized = 1;
+    return MAUS_BUS_OK;
+}
+
+void maus_bus_frame_deinit(void) {
+    _initialized = 0;
+    _started = 0;
+    _gpio_count = 0;
+    _tscode_count = 0;
+    memset(_gpios, 0, sizeof(_gpios));
+    memset(_tscodes, 0, sizeof(_tscodes));
+    maus_bus_frame_reset_stats();
+}
+
+void maus_bus_frame_get_stats(maus_bus_frame_stats_t* stats) {
+    if (stats != NULL) *stats = _stats;
+}
+
+void maus_bus_frame_reset_stats(void) {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+static struct _gpio* _gpio_for(uint8_t address) {
+    size_t pos = 0;
+
+    while (pos < _gpio_count && _gpios[pos].address < address)
+        pos++;
+
+    if (pos < _gpio_count && _gpios[pos].address == address) return &_gpios[pos];
+    if (_gpio_count == MAUS_BUS_FRAME_GPIO_MAX) return NULL;
+
+    memmove(&_gpios[pos + 1], &_gpios[pos], (_gpio_count - pos) * sizeof(*_gpios));
+    memset(&_gpios[pos], 0, sizeof(*_gpios));
+    _gpios[pos].address = address;
+    _gpio_count++;
+
+    return &_gpios[pos];
+}
+
+maus_bus_err_t maus_bus_frame_set_gpio_port(uint8_t address, uint8_t mask, uint8_t levels) {
+    if (!_initialized) return MAUS_BUS_FAIL;
+    if (mask == 0) return MAUS_BUS_OK;
+
+    struct _gpio* gpio = _gpio_for(address);
+    if (gpio == NULL) return MAUS_BUS_NO_MEMORY;
+
+    for (uint8_t replaced = gpio->mask & mask; replaced != 0; replaced &= replaced - 1) {
+        _stats.superseded++;
+    }
+
+    gpio->mask |= mask;
+    gpio->levels = (gpio->levels & ~mask) | (levels & mask);
+
+    return MAUS_BUS_OK;
+}
+
+maus_bus_err_t
+maus_bus_frame_set_gpio(uint8_t address, uint8_t gpio_num, pca9554_gpio_level_t level) {
+    if (gpio_num > 7) return MAUS_BUS_FAIL;
+    return maus_bus_frame_set_gpio_port(address, 1 << gpio_num, level == PCA9554_HIGH ? 0xFF : 0x00);
+}
+
+void maus_bus_frame_invalidate_gpio(uint8_t address) {
+    for (size_t i = 0; i < _gpio_count; i++) {
+        if (_gpios[i].address == address) _gpios[i].known = 0;
+    }
+}
+
+maus_bus_err_t maus_bus_frame_tscode(uint8_t subaddress, const uint8_t* data, size_t len) {
+    struct _tscode* tscode = NULL;
+
+    if (!_initialized) return MAUS_BUS_FAIL;
+    if (len > MAUS_BUS_FRAME_TSCODE_LEN || (len > 0 && data == NULL)) return MAUS_BUS_FAIL;
+
+    for (size_t i = 0; i < _tscode_count; i++) {
+        if (_tscodes[i].subaddress == subaddress) {
+            tscode = &_tscodes[i];
+            break;
+        }
+    }
+
+    if (tscode == NULL) {
+        if (_tscode_count == MAUS_BUS_FRAME_TSCODE_MAX) return MAUS_BUS_NO_MEMORY;
+        tscode = &_tscodes[_tscode_count++];
+        tscode->subaddress = subaddress;
+    }
+
+    if (tscode->pending) _stats.superseded++;
+
+    tscode->pending = 1;
+    tscode->len = (uint8_t)len;
+    if (len > 0) memcpy(tscode->data, data, len);
+
+    return MAUS_BUS_OK;
+}
+
+static uint32_t _estimate_us(uint8_t address, maus_bus_op_t op, size_t len) {
+    if (_config.measure) return 0;
+    return maus_bus_occupancy_estimate_us(op, len, maus_bus_target_clock_hz(address));
+}
+
+static uint32_t _emit_gpio(struct _gpio* gpio) {
+    uint32_t busy_us = 0;
+
+    if (!gpio->known) {
+        // First frame for this expander: pins that weren't staged have to keep their levels.
+        _stats.transactions++;
+        busy_us += _estimate_us(gpio->address, MAUS_BUS_OP_READ, 1);
+
+        if (maus_bus_read_prio(
+                MAUS_BUS_PRIORITY_REALTIME, gpio->address, PCA9554_REG_OUTPUT, &gpio->output, 1
+            ) != MAUS_BUS_OK) {
+            _stats.errors++;
+            return busy_us;
+        }
+
+        gpio->known = 1;
+    }
+
+    uint8_t output = (gpio->output & ~gpio->mask) | (gpio->levels & gpio->mask);
+
+    if (output == gpio->output) {
+        _stats.unchanged++;
+        gpio->mask = 0;
+        return busy_us;
+    }
+
+    _stats.transactions++;
+    busy_us += _estimate_us(gpio->address, MAUS_BUS_OP_WRITE, 1);
+
+    if (pca9554_set_all_gpio_levels(gpio->address, output) != MAUS_BUS_OK) {
+        // Whatever the expander latched is unknown now, so read it again next time.
+        _stats.errors++;
+        gpio->known = 0;
+        return busy_us;
+    }
+
+    gpio->output = output;
+    gpio->mask = 0;
+
+    return busy_us;
+}
+
+static uint32_t _emit_tscode(struct _tscode* tscode) {
+    maus_bus_segment_t segments[] = {
+        {.data = &tscode->subaddress, .len = 1},
+        {.data = tscode->data, .len = tscode->len},
+    };
+
+    _stats.transactions++;
+
+    if (generic_tscode_txv(segments, 2) != MAUS_BUS_OK) {
+        _stats.errors++;
+    } else {
+        tscode->pending = 0;
+    }
+
+    return _estimate_us(TSCODE_ADDRESS, MAUS_BUS_OP_WRITE, tscode->len);
+}
+
+static void _emit(void) {
+    uint32_t start_us = maus_bus_now_us();
+    uint32_t busy_us = 0;
+
+    for (size_t i = 0; i < _gpio_count; i++) {
+        if (_gpios[i].mask != 0) busy_us += _emit_gpio(&_gpios[i]);
+    }
+
+    size_t kept = 0;
+
+    for (size_t i = 0; i < _tscode_count; i++) {
+        if (_tscodes[i].pending) busy_us += _emit_tscode(&_tscodes[i]);
+        if (_tscodes[i].pending) _tscodes[kept++] = _tscodes[i];
+    }
+
+    _tscode_count = kept;
+
+    if (_config.measure) busy_us = maus_bus_now_us() - start_us;
+
+    _stats.frames++;
+    _stats.last_bus_us = busy_us;
+    if (busy_us > _stats.max_bus_us) _stats.max_bus_us = busy_us;
+    if (busy_us > _config.period_ms * 1000) _stats.overruns++;
+}
+
+int maus_bus_frame_tick(uint32_t now_ms) {
+    if (!_initialized) return 0;
+
+    if (!_started) {
+        _started = 1;
+        _next_ms = now_ms;
+    }
+
+    // Signed, so a tick that comes early doesn't look like one that is 49 days late.
+    int32_t late_ms = (int32_t)(now_ms - _next_ms);
+    if (late_ms < 0) return 0;
+
+    if ((uint32_t)late_ms > _stats.max_late_ms) _stats.max_late_ms = (uint32_t)late_ms;
+
+    // Slots that went by entirely are dropped, their updates ride along with this frame.
+    uint32_t skipped = (uint32_t)late_ms / _config.period_ms;
+    _stats.missed += skipped;
+    _next_ms += (skipped + 1) * _config.period_ms;
+
+    _emit();
+    return 1;
+}
@@ -0,0 +1,224 @@
+#include "maus_bus_hotplug.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BITMAP_WORDS (128 / 32)
+#define BITMAP_TEST(map, addr) (((map)[(addr) >> 5] >> ((addr)&0x1F)) & 1)
+#define BITMAP_SET(map, addr) ((map)[(addr) >> 5] |= (1UL << ((addr)&0x1F)))
+
+static maus_bus_hotplug_config_t _config = {
+    .debounce_ms = 0,
+    .max_hold_ms = 0,
+    .queue_len = 0,
+};
+
+static maus_bus_hotplug_event_t* _queue = NULL;
+static size_t _queue_head = 0;
+static size_t _queue_count = 0;
+
+static maus_bus_hotplug_stats_t _stats;
+
+// Written from the edge ISR, read from the tick.
+static volatile int _pending = 0;
+static volatile uint32_t _burst_start_ms = 0;
+static volatile uint32_t _last_edge_ms = 0;
+
+// Addresses that answered on the last rescan.
+static uint32_t _present[BITMAP_WORDS];
+
+struct _rescan_state {
+    uint32_t present[BITMAP_WORDS];
+    uint32_t registered[BITMAP_WORDS];
+    size_t events;
+};
+
+maus_bus_err_t maus_bus_hotplug_init(const maus_bus_hotplug_config_t* config) {
+    if (config == NULL || config->queue_len == 0) return MAUS_BUS_FAIL;
+
+    maus_bus_hotplug_deinit();
+
+    _queue = (maus_bus_hotplug_event_t*)calloc(config->queue_len, sizeof(maus_bus_hotplug_event_t));
+    if (_queue == NULL) return MAUS_BUS_NO_MEMORY;
+
+    _config = *config;
+    return MAUS_BUS_OK;
+}
+
+void maus_bus_hotplug_deinit(void) {
+    free(_queue);
+    _queue = NULL;
+    _queue_head = 0;
+    _queue_count = 0;
+    _pending = 0;
+    memset(&_stats, 0, sizeof(_stats));
+    memset(_present, 0, sizeof(_present));
+}
+
+maus_bus_err_t maus_bus_hotplug_post(const maus_bus_hotplug_event_t* event) {
+    if (_queue == NULL || event == NULL) return MAUS_BUS_FAIL;
+
+    if (_queue_count == _config.queue_len) {
+        _queue_head = (_queue_head + 1) % _config.queue_len;
+        _queue_count--;
+        _stats.dropped++;
+    }
+
+    _queue[(_queue_head + _queue_count) % _config.queue_len] = *event;
+    _queue_count++;
+    _stats.events++;
+
+    return MAUS_BUS_OK;
+}
+
+int maus_bus_hotplug_poll(maus_bus_hotplug_event_t* event) {
+    if (_queue == NULL || _queue_count == 0) return 0;
+
+    if (event != NULL) *event = _queue[_queue_head];
+    _queue_head = (_queue_head + 1) % _config.queue_len;
+    _queue_count--;
+
+    return 1;
+}
+
+void maus_bus_hotplug_get_stats(maus_bus_hotplug_stats_t* stats) {
+    if (stats != NULL) *stats = _stats;
+}
+
+void maus_bus_hotplug_edge(uint32_t now_ms) {
+    if (!_pending) {
+        _burst_start_ms = now_ms;
+        _pending = 1;
+    }
+
+    _last_edge_ms = now_ms;
+    _stats.edges++;
+}
+
+static int _is_answering(maus_bus_status_t status) {
+    return status == MAUS_BUS_STATUS_CONNECTED || status == MAUS_BUS_STATUS_PROBED;
+}
+
+maus_bus_err_t maus_bus_hotplug_post_status(
+    maus_bus_address_t address,
+    maus_bus_status_t old_status,
+    maus_bus_status_t new_status,
+    int registered
+) {
+    maus_bus_hotplug_event_t event;
+    memset(&event, 0, sizeof(event));
+
+    if (_queue == NULL || address == NULL) return MAUS_BUS_FAIL;
+
+    if (_is_answering(old_status) == _is_answering(new_status)) {
+        event.type = MAUS_BUS_EVENT_STATUS_CHANGED;
+    } else if (_is_answering(new_status)) {
+        event.type = MAUS_BUS_EVENT_CONNECTED;
+    } else {
+        event.type = MAUS_BUS_EVENT_DISCONNECTED;
+    }
+
+    size_t depth = maus_bus_get_address_depth(address);
+    if (depth > MAUS_BUS_ADDRESS_MAX_DEPTH) depth = MAUS_BUS_ADDRESS_MAX_DEPTH;
+    memcpy(event.address, address, depth);
+
+    event.old_status = old_status;
+    event.new_status = new_status;
+    event.registered = registered;
+
+    return maus_bus_hotplug_post(&event);
+}
+
+static void _emit(
+    struct _rescan_state* state,
+    maus_bus_address_t address,
+    maus_bus_status_t old_status,
+    maus_bus_status_t new_status,
+    int registered
+) {
+    if (maus_bus_hotplug_post_status(address, old_status, new_status, registered) == MAUS_BUS_OK) {
+        state->events++;
+    }
+}
+
+static void _on_scan(maus_bus_device_t* device, maus_bus_address_t address, void* ptr) {
+    struct _rescan_state* state = (struct _rescan_state*)ptr;
+    BITMAP_SET(state->present, maus_bus_get_final_address(address));
+}
+
+static void _check_registered(
+    maus_bus_driver_t* driver, maus_bus_device_t* device, maus_bus_address_t address, void* ptr
+) {
+    struct _rescan_state* state = (struct _rescan_state*)ptr;
+    uint8_t final = maus_bus_get_final_address(address);
+    maus_bus_status_t old_status = MAUS_BUS_STATUS_DISCONNECTED;
+    maus_bus_status_t new_status = MAUS_BUS_STATUS_DISCONNECTED;
+
+    maus_bus_get_device_status(address, &old_status);
+    BITMAP_SET(state->registered, final);
+
+    if (device->__guard == 0xCAFE) {
+        // Identified devices were already re-read by the quick scan, just compare IDs.
+        const maus_bus_device_t* scanned = maus_bus_get_scan_item_by_address(address);
+
+        if (scanned != NULL) {
+            int same = scanned->vendor_id == device->vendor_id &&
+                       scanned->product_id == device->product_id &&
+                       scanned->serial == device->serial;
+            new_status = same ? MAUS_BUS_STATUS_CONNECTED : MAUS_BUS_STATUS_PROBED;
+        }
+    } else if (maus_bus_probe(final) == MAUS_BUS_OK) {
+        BITMAP_SET(state->present, final);
+        new_status = MAUS_BUS_STATUS_CONNECTED;
+    }
+
+    if (new_status == old_status) return;
+
+    maus_bus_set_device_status(address, new_status);
+    _emit(state, address, old_status, new_status, 1);
+}
+
+static size_t _rescan(void) {
+    struct _rescan_state state;
+    memset(&state, 0, sizeof(state));
+
+    maus_bus_free_device_scan();
+    maus_bus_scan_bus_quick(&_on_scan, &state);
+    maus_bus_enumerate_devices(&_check_registered, &state);
+
+    // Whatever is left over is an identified device nobody has registered (yet).
+    for (uint8_t addr = 0; addr < 128; addr++) {
+        int was = BITMAP_TEST(_present, addr);
+        int is = BITMAP_TEST(state.present, addr);
+
+        if (was == is || BITMAP_TEST(state.registered, addr)) continue;
+
+        uint8_t address[] = { addr, 0x00 };
+        _emit(
+            &state,
+            address,
+            was ? MAUS_BUS_STATUS_CONNECTED : MAUS_BUS_STATUS_DISCONNECTED,
+            is ? MAUS_BUS_STATUS_CONNECTED : MAUS_BUS_STATUS_DISCONNECTED,
+            0
+        );
+    }
+
+    memcpy(_present, state.present, sizeof(_present));
+    _stats.rescans++;
+
+    return state.events;
+}
+
+size_t maus_bus_hotplug_tick(uint32_t now_ms) {
+    if (_queue == NULL || !_pending) return 0;
+
+    uint32_t quiet_ms = now_ms - _last_edge_ms;
+    uint32_t held_ms = now_ms - _burst_start_ms;
+
+    if (quiet_ms < _config.debounce_ms) {
+        if (_config.max_hold_ms == 0 || held_ms < _config.max_hold_ms) return 0;
+    }
+
+    // Clear first, so an edge arriving mid-rescan starts a new burst instead of being lost.
+    _pending = 0;
+    return _rescan();
+}
@@ -0,0 +1,55 @@
+#ifndef __mt_accessory_common__maus_bus_internal_h
+#define __mt_accessory_common__maus_bus_internal_h
+
+/**
+ * Library-internal helpers shared between the core and its optional modules. Not installed, not
+ * part of the public API.
+ */
+
+#include "maus_bus.h"
+#include "maus_bus_occupancy.h"
+
+/**
+ * @brief Appends a device to the scan results without touching the bus, as if a scan had found it.
+ *
+ * @param address
+ * @param device Copied into the scan list.
+ * @return maus_bus_device_t* The stored copy, or NULL if out of memory.
+ */
+maus_bus_device_t*
+maus_bus_scan_add_device(maus_bus_address_t address, const maus_bus_device_t* device);
+
+/**
+ * @brief Reads with exactly one attempt, bypassing the device's retries and fail-fast breaker the
+ * way probes do. For callers that meter their own bus time and need to see the device as it is.
+ *
+ * @param address
+ * @param subaddress
+ * @param data
+ * @param len
+ * @return maus_bus_err_t Straight from the backend.
+ */
+maus_bus_err_t
+maus_bus_read_unguarded(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len);
+
+/**
+ * @brief Whether occupancy accounting wants transactions timed, so the dispatcher only reads the
+ * clock when someone uses the result.
+ */
+int maus_bus_occupancy_measuring(void);
+
+/**
+ * @brief Bills one transaction to its address and consumer. Called by the dispatcher after every
+ * backend call, successful or not, since a NACK occupies the bus too.
+ *
+ * @param address
+ * @param op
+ * @param len Payload bytes.
+ * @param measured_us Time the backend call took, only used when measuring.
+ * @param scanning Non-zero if a scan sent it.
+ */
+void maus_bus_occupancy_record(
+    uint8_t address, maus_bus_op_t op, size_t len, uint32_t measured_us, int scanning
+);
+
+#endif
@@ -0,0 +1,176 @@
+#include "maus_bus_monitor.h"
+#include "maus_bus_hotplug.h"
+#include "maus_bus_internal.h"
+#include "maus_bus_occupancy.h"
+#include <string.h>
+
+#include "drivers/sc16is740.h"
+
+static maus_bus_monitor_config_t _config = {
+    .interval_ms = 0,
+    .budget_permille = 0,
+};
+
+static int _initialized = 0;
+static int _started = 0;
+static size_t _cursor = 0;
+static uint32_t _credit_us = 0;
+static uint32_t _last_tick_ms = 0;
+static uint32_t _next_slot_ms = 0;
+static maus_bus_monitor_stats_t _stats;
+
+struct _selection {
+    size_t target;
+    size_t index;
+    maus_bus_device_t* device;
+    maus_bus_address_t address;
+};
+
+maus_bus_err_t maus_bus_monitor_init(const maus_bus_monitor_config_t* config) {
+    if (config == NULL || config->budget_permille == 0) return MAUS_BUS_FAIL;
+
+    _config = *config;
+
+    _initialized = 1;
+    _started = 0;
+    _cursor = 0;
+    _credit_us = 0;
+    memset(&_stats, 0, sizeof(_stats));
+
+    return MAUS_BUS_OK;
+}
+
+void maus_bus_monitor_get_stats(maus_bus_monitor_stats_t* stats) {
+    if (stats != NULL) *stats = _stats;
+}
+
+maus_bus_check_t maus_bus_monitor_check_for(const maus_bus_device_t* device) {
+    if (device->features.serial) return MAUS_BUS_CHECK_SC16_SPR;
+    if (device->__guard == 0xCAFE) return MAUS_BUS_CHECK_GUARD;
+    return MAUS_BUS_CHECK_PROBE;
+}
+
+static uint32_t _check_cost_us(maus_bus_check_t check, uint32_t clock_hz) {
+    if (check == MAUS_BUS_CHECK_GUARD) {
+        return maus_bus_occupancy_estimate_us(MAUS_BUS_OP_READ, 2, clock_hz);
+    }
+
+    if (check == MAUS_BUS_CHECK_SC16_SPR) {
+        return maus_bus_occupancy_estimate_us(MAUS_BUS_OP_READ, 1, clock_hz);
+    }
+
+    return maus_bus_occupancy_estimate_us(MAUS_BUS_OP_PROBE, 0, clock_hz);
+}
+
+static uint8_t _check_target(maus_bus_check_t check, uint8_t address) {
+    return check == MAUS_BUS_CHECK_SC16_SPR ? SC16_ADDRESS : address;
+}
+
+// Reads go around the retry and fail-fast logic, so every check is exactly the one transaction
+// _check_cost_us charged for, and a device that is failing fast still gets its status checked.
+static maus_bus_err_t _run_check(maus_bus_check_t check, uint8_t address) {
+    maus_bus_err_t err = MAUS_BUS_OK;
+
+    switch (check) {
+    case MAUS_BUS_CHECK_GUARD: {
+        uint16_t guard = 0x0000;
+        err = maus_bus_read_unguarded(address, 0x00, (uint8_t*)&guard, 2);
+        if (err == MAUS_BUS_OK && guard != 0xCAFE) err = MAUS_BUS_FAIL;
+        return err;
+    }
+
+    case MAUS_BUS_CHECK_SC16_SPR: {
+        uint8_t tmp = 0x00;
+        return maus_bus_read_unguarded(address, SC16_REG_SPR << 3, &tmp, 1);
+    }
+
+    default:
+        return maus_bus_probe(address);
+    }
+}
+
+static void _count_device(
+    maus_bus_driver_t* driver, maus_bus_device_t* device, maus_bus_address_t address, void* ptr
+) {
+    (*(size_t*)ptr)++;
+}
+
+static void _select_device(
+    maus_bus_driver_t* driver, maus_bus_device_t* device, maus_bus_address_t address, void* ptr
+) {
+    struct _selection* sel = (struct _selection*)ptr;
+
+    if (sel->index++ != sel->target) return;
+    sel->device = device;
+    sel->address = address;
+}
+
+int maus_bus_monitor_tick(uint32_t now_ms) {
+    if (!_initialized) return 0;
+
+    if (!_started) {
+        _started = 1;
+        _last_tick_ms = now_ms;
+        _next_slot_ms = now_ms;
+    }
+
+    // Refill: budget_permille of each elapsed millisecond, in microseconds. The bucket only holds
+    // two of the most expensive checks, so a long pause can't turn into a burst of checks.
+    uint64_t refill = (uint64_t)(now_ms - _last_tick_ms) * _config.budget_permille;
+    uint32_t cap = 2 * _check_cost_us(MAUS_BUS_CHECK_GUARD, maus_bus_speed_hz(MAUS_BUS_SPEED_STANDARD));
+    _last_tick_ms = now_ms;
+    _credit_us = (uint32_t)((_credit_us + refill > cap) ? cap : _credit_us + refill);
+
+    size_t count = 0;
+    maus_bus_enumerate_devices(&_count_device, &count);
+    if (count == 0) return 0;
+
+    if ((int32_t)(now_ms - _next_slot_ms) < 0) return 0;
+
+    struct _selection sel = {
+        .target = _cursor % count,
+        .index = 0,
+        .device = NULL,
+        .address = NULL,
+    };
+
+    maus_bus_enumerate_devices(&_select_device, &sel);
+    if (sel.device == NULL) return 0;
+
+    maus_bus_check_t check = maus_bus_monitor_check_for(sel.device);
+    uint8_t target = _check_target(check, maus_bus_get_final_address(sel.address));
+    uint32_t cost = _check_cost_us(check, maus_bus_target_clock_hz(target));
+
+    if (_credit_us < cost) {
+        _stats.deferred++;
+        return 0;
+    }
+
+    maus_bus_err_t err = _run_check(check, target);
+
+    _credit_us -= cost;
+    _stats.checks++;
+    _stats.spent_us += cost;
+    _cursor = (_cursor + 1) % count;
+    _next_slot_ms = now_ms + _config.interval_ms / count;
+
+    maus_bus_status_t old_status = MAUS_BUS_STATUS_DISCONNECTED;
+    maus_bus_status_t new_status = MAUS_BUS_STATUS_DISCONNECTED;
+    maus_bus_get_device_status(sel.address, &old_status);
+
+    if (err == MAUS_BUS_OK) {
+        // A mismatched ID stays PROBED until the device is registered again.
+        new_status = old_status == MAUS_BUS_STATUS_PROBED ? MAUS_BUS_STATUS_PROBED
+                                                          : MAUS_BUS_STATUS_CONNECTED;
+    } else {
+        _stats.failures++;
+        new_status = err == MAUS_BUS_TIMEOUT ? MAUS_BUS_STATUS_TIMEOUT : MAUS_BUS_STATUS_DISCONNECTED;
+    }
+
+    if (new_status != old_status) {
+        maus_bus_set_device_status(sel.address, new_status);
+        maus_bus_hotplug_post_status(sel.address, old_status, new_status, 1);
+    }
+
+    return 1;
+}
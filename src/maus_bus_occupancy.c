@@ -0,0 +1,189 @@
+#include "maus_bus_occupancy.h"
+#include "maus_bus_internal.h"
+#include <string.h>
+
+#include "drivers/generic_tscode.h"
+#include "drivers/pca9554.h"
+#include "drivers/sc16is740.h"
+
+// Bus clocks per transaction, counting start/stop and the ACK on every byte:
+#define PROBE_CLOCKS (1 + 9 + 1)
+#define WRITE_CLOCKS(n) (1 + 9 + 9 + ((n)*9) + 1)
+#define READ_CLOCKS(n) (1 + 9 + 9 + 1 + 9 + ((n)*9) + 1)
+
+static maus_bus_occupancy_config_t _config = {
+    .window_ms = 0,
+    .measure = 0,
+};
+
+static int _initialized = 0;
+static int _started = 0;
+
+static maus_bus_occupancy_counter_t _consumers[MAUS_BUS_CONSUMER_MAX];
+static maus_bus_occupancy_counter_t _addresses[128];
+
+static struct _window {
+    uint32_t busy_us;
+    uint32_t length_us;
+} _windows[MAUS_BUS_OCCUPANCY_WINDOWS];
+
+static size_t _window_head = 0;
+static size_t _window_count = 0;
+static uint32_t _window_start_ms = 0;
+static uint32_t _window_busy_us = 0;
+
+maus_bus_err_t maus_bus_occupancy_init(const maus_bus_occupancy_config_t* config) {
+    if (config == NULL || config->window_ms == 0) return MAUS_BUS_FAIL;
+
+    maus_bus_occupancy_deinit();
+
+    _config = *config;
+
+    _initialized = 1;
+    return MAUS_BUS_OK;
+}
+
+void maus_bus_occupancy_deinit(void) {
+    _initialized = 0;
+    _started = 0;
+    _window_head = 0;
+    _window_count = 0;
+    _window_busy_us = 0;
+    memset(_windows, 0, sizeof(_windows));
+    maus_bus_occupancy_reset();
+}
+
+void maus_bus_occupancy_reset(void) {
+    memset(_consumers, 0, sizeof(_consumers));
+    memset(_addresses, 0, sizeof(_addresses));
+}
+
+uint32_t maus_bus_occupancy_estimate_us(maus_bus_op_t op, size_t len, uint32_t bus_clock_hz) {
+    uint64_t clocks = PROBE_CLOCKS;
+
+    if (bus_clock_hz == 0) bus_clock_hz = 100000;
+    if (op == MAUS_BUS_OP_WRITE) clocks = WRITE_CLOCKS((uint64_t)len);
+    if (op == MAUS_BUS_OP_READ) clocks = READ_CLOCKS((uint64_t)len);
+
+    return (uint32_t)((clocks * 1000000 + bus_clock_hz - 1) / bus_clock_hz);
+}
+
+int maus_bus_occupancy_measuring(void) {
+    return _initialized && _config.measure;
+}
+
+static maus_bus_consumer_t _consumer_of(uint8_t address, int scanning) {
+    if (scanning) return MAUS_BUS_CONSUMER_SCAN;
+    if (address == SC16_ADDRESS) return MAUS_BUS_CONSUMER_SC16;
+    if ((address & 0x78) == PCA9554_ADDRESS || (address & 0x78) == PCA9554A_ADDRESS) {
+        return MAUS_BUS_CONSUMER_PCA9554;
+    }
+    if (address == TSCODE_ADDRESS) return MAUS_BUS_CONSUMER_TSCODE;
+    if ((address & 0x78) == 0x50) return MAUS_BUS_CONSUMER_EEPROM;
+    return MAUS_BUS_CONSUMER_OTHER;
+}
+
+static void _count(maus_bus_occupancy_counter_t* counter, size_t len, uint32_t busy_us) {
+    counter->transactions++;
+    counter->bytes += len;
+    counter->busy_us += busy_us;
+}
+
+void maus_bus_occupancy_record(
+    uint8_t address, maus_bus_op_t op, size_t len, uint32_t measured_us, int scanning
+) {
+    if (!_initialized) return;
+
+    uint32_t busy_us =
+        _config.measure ? measured_us
+                        : maus_bus_occupancy_estimate_us(op, len, maus_bus_target_clock_hz(address));
+
+    _count(&_consumers[_consumer_of(address, scanning)], len, busy_us);
+    _count(&_addresses[address & 0x7F], len, busy_us);
+    _window_busy_us += busy_us;
+}
+
+void maus_bus_occupancy_tick(uint32_t now_ms) {
+    if (!_initialized) return;
+
+    if (!_started) {
+        _started = 1;
+        _window_start_ms = now_ms;
+        _window_busy_us = 0;
+        return;
+    }
+
+    uint32_t elapsed_ms = now_ms - _window_start_ms;
+    if (elapsed_ms < _config.window_ms) return;
+
+    struct _window* window = &_windows[(_window_head + _window_count) % MAUS_BUS_OCCUPANCY_WINDOWS];
+
+    if (_window_count == MAUS_BUS_OCCUPANCY_WINDOWS) {
+        _window_head = (_window_head + 1) % MAUS_BUS_OCCUPANCY_WINDOWS;
+    } else {
+        _window_count++;
+    }
+
+    window->length_us = elapsed_ms * 1000;
+    // Estimates can overshoot a window that was saturated, and nothing is busier than 100%.
+    window->busy_us = _window_busy_us > window->length_us ? window->length_us : _window_busy_us;
+
+    _window_start_ms = now_ms;
+    _window_busy_us = 0;
+}
+
+static uint16_t _permille(uint64_t part, uint64_t whole) {
+    return whole == 0 ? 0 : (uint16_t)((part * 1000) / whole);
+}
+
+void maus_bus_occupancy_get_summary(maus_bus_occupancy_summary_t* summary) {
+    if (summary == NULL) return;
+
+    uint64_t length_us = 0;
+    memset(summary, 0, sizeof(*summary));
+
+    for (size_t i = 0; i < _window_count; i++) {
+        const struct _window* window = &_windows[(_window_head + i) % MAUS_BUS_OCCUPANCY_WINDOWS];
+        uint16_t permille = _permille(window->busy_us, window->length_us);
+
+        summary->busy_us += window->busy_us;
+        length_us += window->length_us;
+        if (permille > summary->peak_permille) summary->peak_permille = permille;
+    }
+
+    summary->windows = (uint32_t)_window_count;
+    summary->idle_us = length_us - summary->busy_us;
+    summary->utilization_permille = _permille(summary->busy_us, length_us);
+}
+
+maus_bus_err_t
+maus_bus_occupancy_get_consumer(maus_bus_consumer_t consumer, maus_bus_occupancy_counter_t* counter) {
+    if (consumer >= MAUS_BUS_CONSUMER_MAX || counter == NULL) return MAUS_BUS_FAIL;
+    *counter = _consumers[consumer];
+    return MAUS_BUS_OK;
+}
+
+size_t maus_bus_occupancy_top(maus_bus_occupancy_top_t* top, size_t max) {
+    size_t count = 0;
+
+    if (top == NULL) return 0;
+
+    // Insertion into a list of at most max entries, so this is 128 * max at worst.
+    for (uint8_t addr = 0; addr < 128; addr++) {
+        const maus_bus_occupancy_counter_t* counter = &_addresses[addr];
+        if (counter->transactions == 0) continue;
+
+        size_t pos = count;
+        while (pos > 0 && top[pos - 1].counter.busy_us < counter->busy_us)
+            pos--;
+
+        if (pos >= max) continue;
+        if (count < max) count++;
+
+        memmove(&top[pos + 1], &top[pos], (count - pos - 1) * sizeof(*top));
+        top[pos].address = addr;
+        top[pos].counter = *counter;
+    }
+
+    return count;
+}
@@ -0,0 +1,220 @@
+#include "maus_bus_snapshot.h"
+#include "maus_bus_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "drivers/generic_tscode.h"
+#include "drivers/sc16is740.h"
+
+// Guard, VID, PID and serial. Enough to tell whether the same accessory is still plugged in.
+#define IDENTITY_LEN 8
+
+#define SNAPSHOT_MAX_LEN                                                                           \
+    (sizeof(maus_bus_snapshot_header_t) +                                                          \
+     (MAUS_BUS_SNAPSHOT_MAX_DEVICES * sizeof(maus_bus_snapshot_entry_t)))
+
+struct _save_state {
+    maus_bus_snapshot_entry_t* entries;
+    size_t count;
+    int overflow;
+};
+
+struct _binding_lookup {
+    maus_bus_address_t address;
+    uint8_t binding;
+};
+
+static uint16_t _crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+
+    return crc;
+}
+
+static uint8_t _binding_of(const maus_bus_driver_t* driver) {
+    uint8_t binding = 0;
+
+    if (driver->uart != NULL && driver->uart->transmit == &sc16_tx) {
+        binding |= MAUS_BUS_BINDING_SC16;
+    } else if (driver->uart != NULL && driver->uart->transmit == &generic_tscode_tx) {
+        binding |= MAUS_BUS_BINDING_TSCODE;
+    }
+
+    if (driver->gpio != NULL) binding |= MAUS_BUS_BINDING_GPIO;
+
+    return binding;
+}
+
+static void _save_device(
+    maus_bus_driver_t* driver, maus_bus_device_t* device, maus_bus_address_t address, void* ptr
+) {
+    struct _save_state* state = (struct _save_state*)ptr;
+    size_t depth = maus_bus_get_address_depth(address);
+
+    if (state->count >= MAUS_BUS_SNAPSHOT_MAX_DEVICES || depth > MAUS_BUS_ADDRESS_MAX_DEPTH) {
+        state->overflow = 1;
+        return;
+    }
+
+    maus_bus_snapshot_entry_t* entry = &state->entries[state->count++];
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->address, address, depth);
+    entry->binding = _binding_of(driver);
+    memcpy(&entry->device, device, sizeof(maus_bus_device_t));
+}
+
+maus_bus_err_t maus_bus_snapshot_save(maus_bus_snapshot_write_fn write, void* ptr) {
+    if (write == NULL) return MAUS_BUS_FAIL;
+
+    uint8_t* blob = (uint8_t*)calloc(1, SNAPSHOT_MAX_LEN);
+    if (blob == NULL) return MAUS_BUS_NO_MEMORY;
+
+    maus_bus_snapshot_header_t* header = (maus_bus_snapshot_header_t*)blob;
+    struct _save_state state = {
+        .entries = (maus_bus_snapshot_entry_t*)(blob + sizeof(maus_bus_snapshot_header_t)),
+        .count = 0,
+        .overflow = 0,
+    };
+
+    maus_bus_enumerate_devices(&_save_device, &state);
+
+    if (state.overflow) {
+        free(blob);
+        return MAUS_BUS_NO_MEMORY;
+    }
+
+    size_t entries_len = state.count * sizeof(maus_bus_snapshot_entry_t);
+
+    header->magic = MAUS_BUS_SNAPSHOT_MAGIC;
+    header->version = MAUS_BUS_SNAPSHOT_VERSION;
+    header->count = (uint8_t)state.count;
+    header->crc = _crc16((uint8_t*)state.entries, entries_len);
+
+    maus_bus_err_t err = write(blob, sizeof(maus_bus_snapshot_header_t) + entries_len, ptr);
+    free(blob);
+    return err;
+}
+
+static int _is_valid(const uint8_t* blob, size_t len) {
+    const maus_bus_snapshot_header_t* header = (const maus_bus_snapshot_header_t*)blob;
+
+    if (len < sizeof(maus_bus_snapshot_header_t)) return 0;
+    if (header->magic != MAUS_BUS_SNAPSHOT_MAGIC) return 0;
+    if (header->version != MAUS_BUS_SNAPSHOT_VERSION) return 0;
+    if (header->count > MAUS_BUS_SNAPSHOT_MAX_DEVICES) return 0;
+
+    size_t entries_len = header->count * sizeof(maus_bus_snapshot_entry_t);
+    if (len != sizeof(maus_bus_snapshot_header_t) + entries_len) return 0;
+
+    return _crc16(blob + sizeof(maus_bus_snapshot_header_t), entries_len) == header->crc;
+}
+
+static void _lookup_binding(
+    maus_bus_driver_t* driver, maus_bus_device_t* device, maus_bus_address_t address, void* ptr
+) {
+    struct _binding_lookup* lookup = (struct _binding_lookup*)ptr;
+    if (maus_bus_addrcmp(address, lookup->address)) lookup->binding = _binding_of(driver);
+}
+
+static void _restore_entry(
+    maus_bus_snapshot_entry_t* entry,
+    maus_bus_scan_callback_t cb,
+    void* cb_ptr,
+    maus_bus_snapshot_result_t* result
+) {
+    uint8_t address = maus_bus_get_final_address(entry->address);
+
+    if (entry->device.__guard == 0xCAFE) {
+        uint8_t identity[IDENTITY_LEN];
+        uint16_t guard = 0x0000;
+
+        // One attempt, like the probe below. A device that went away while powered off shouldn't
+        // cost retries and backoff, or trip its breaker, on the way to being dropped.
+        maus_bus_err_t err = maus_bus_read_unguarded(address, 0x00, identity, IDENTITY_LEN);
+        memcpy(&guard, identity, sizeof(guard));
+
+        if (err != MAUS_BUS_OK || guard != 0xCAFE) {
+            result->dropped++;
+            return;
+        }
+
+        if (memcmp(identity, &entry->device, IDENTITY_LEN) != 0) {
+            // Someone swapped accessories. Read the new one properly, but leave registering it
+            // to the application, same as after a scan.
+            maus_bus_device_t device;
+            maus_bus_read_prio(
+                MAUS_BUS_PRIORITY_BULK, address, 0x00, (uint8_t*)&device, sizeof(device)
+            );
+            device.vendor_name[MAUS_BUS_VENDOR_MAX_LENGTH] = '\0';
+            device.product_name[MAUS_BUS_PRODUCT_MAX_LENGTH] = '\0';
+
+            maus_bus_device_t* stored = maus_bus_scan_add_device(entry->address, &device);
+            if (stored != NULL && cb != NULL) (*cb)(stored, entry->address, cb_ptr);
+
+            result->rescanned++;
+            return;
+        }
+    } else if (maus_bus_probe(address) != MAUS_BUS_OK) {
+        result->dropped++;
+        return;
+    }
+
+    maus_bus_device_t* stored = maus_bus_scan_add_device(entry->address, &entry->device);
+    if (stored == NULL) return;
+
+    if (maus_bus_register_device(entry->address) != MAUS_BUS_OK) return;
+
+    struct _binding_lookup lookup = {
+        .address = entry->address,
+        .binding = 0,
+    };
+
+    maus_bus_enumerate_devices(&_lookup_binding, &lookup);
+    if (lookup.binding != entry->binding) result->rebound++;
+
+    result->restored++;
+    if (cb != NULL) (*cb)(stored, entry->address, cb_ptr);
+}
+
+maus_bus_err_t maus_bus_snapshot_restore(
+    maus_bus_snapshot_read_fn read,
+    void* ptr,
+    maus_bus_scan_callback_t cb,
+    void* cb_ptr,
+    maus_bus_snapshot_result_t* result
+) {
+    maus_bus_snapshot_result_t tmp;
+    size_t len = 0;
+
+    if (result == NULL) result = &tmp;
+    memset(result, 0, sizeof(*result));
+
+    uint8_t* blob = (uint8_t*)malloc(SNAPSHOT_MAX_LEN);
+    if (blob == NULL) return MAUS_BUS_NO_MEMORY;
+
+    if (read == NULL || read(blob, SNAPSHOT_MAX_LEN, &len, ptr) != MAUS_BUS_OK ||
+        !_is_valid(blob, len)) {
+        free(blob);
+        result->full_scan = 1;
+        maus_bus_scan_bus_full(cb, cb_ptr);
+        return MAUS_BUS_OK;
+    }
+
+    const maus_bus_snapshot_header_t* header = (const maus_bus_snapshot_header_t*)blob;
+    maus_bus_snapshot_entry_t* entries =
+        (maus_bus_snapshot_entry_t*)(blob + sizeof(maus_bus_snapshot_header_t));
+
+    for (size_t i = 0; i < header->count; i++) {
+        entries[i].address[MAUS_BUS_ADDRESS_MAX_DEPTH] = 0x00;
+        if (entries[i].address[0] == 0x00) continue;
+        _restore_entry(&entries[i], cb, cb_ptr, result);
+    }
+
+    free(blob);
+    return MAUS_BUS_OK;
+}
@@ -0,0 +1,235 @@
+#include "maus_bus_sim_client.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static int _fd = -1;
+
+static int _read_full(void* buf, size_t len) {
+    uint8_t* p = (uint8_t*)buf;
+
+    while (len > 0) {
+        ssize_t n = read(_fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+static int _writev_full(struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(_fd, iov, iovcnt);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+
+        // Advance past whatever was sent:
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0) {
+            iov->iov_base = (uint8_t*)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Sends one request made of a header and any number of payload segments, then waits for
+ * the reply and scatters its payload into the reply segments.
+ */
+static maus_bus_err_t _transact(
+    maus_bus_sim_msg_t* msg,
+    const maus_bus_segment_t* tx,
+    size_t tx_count,
+    const maus_bus_segment_t* rx,
+    size_t rx_count
+) {
+    struct iovec iov[MAUS_BUS_SEGMENTS_MAX + 1];
+    int iovcnt = 0;
+
+    if (_fd < 0) return MAUS_BUS_FAIL;
+    if (tx_count > MAUS_BUS_SEGMENTS_MAX) return MAUS_BUS_NOT_SUPPORTED;
+
+    iov[iovcnt].iov_base = msg;
+    iov[iovcnt].iov_len = sizeof(*msg);
+    iovcnt++;
+
+    for (size_t i = 0; i < tx_count; i++) {
+        if (tx[i].len == 0) continue;
+        iov[iovcnt].iov_base = tx[i].data;
+        iov[iovcnt].iov_len = tx[i].len;
+        iovcnt++;
+    }
+
+    if (_writev_full(iov, iovcnt) != 0) return MAUS_BUS_FAIL;
+
+    maus_bus_sim_msg_t reply;
+    if (_read_full(&reply, sizeof(reply)) != 0) return MAUS_BUS_FAIL;
+
+    size_t remaining = reply.len;
+
+    for (size_t i = 0; i < rx_count && remaining > 0; i++) {
+        size_t n = rx[i].len < remaining ? rx[i].len : remaining;
+        if (_read_full(rx[i].data, n) != 0) return MAUS_BUS_FAIL;
+        remaining -= n;
+    }
+
+    // Drain anything we didn't have room for.
+    while (remaining > 0) {
+        uint8_t discard[64];
+        size_t n = remaining < sizeof(discard) ? remaining : sizeof(discard);
+        if (_read_full(discard, n) != 0) return MAUS_BUS_FAIL;
+        remaining -= n;
+    }
+
+    return (maus_bus_err_t)reply.status;
+}
+
+static size_t _total_len(const maus_bus_segment_t* segments, size_t count) {
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++)
+        len += segments[i].len;
+    return len;
+}
+
+static maus_bus_err_t _sim_writev(
+    uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count
+) {
+    size_t len = _total_len(segments, count);
+    if (len > MAUS_BUS_SIM_MAX_PAYLOAD) return MAUS_BUS_NOT_SUPPORTED;
+
+    maus_bus_sim_msg_t msg = {
+        .op = MAUS_BUS_SIM_OP_WRITE,
+        .address = address,
+        .subaddress = subaddress,
+        .status = 0,
+        .len = (uint16_t)len,
+    };
+
+    return _transact(&msg, segments, count, NULL, 0);
+}
+
+static maus_bus_err_t _sim_readv(
+    uint8_t address, uint8_t subaddress, const maus_bus_segment_t* segments, size_t count
+) {
+    size_t len = _total_len(segments, count);
+    if (len > MAUS_BUS_SIM_MAX_PAYLOAD) return MAUS_BUS_NOT_SUPPORTED;
+
+    maus_bus_sim_msg_t msg = {
+        .op = MAUS_BUS_SIM_OP_READ,
+        .address = address,
+        .subaddress = subaddress,
+        .status = 0,
+        .len = (uint16_t)len,
+    };
+
+    return _transact(&msg, NULL, 0, segments, count);
+}
+
+static maus_bus_err_t _sim_write(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len) {
+    maus_bus_segment_t segment = { .data = data, .len = len };
+    return _sim_writev(address, subaddress, &segment, 1);
+}
+
+static maus_bus_err_t _sim_read(uint8_t address, uint8_t subaddress, uint8_t* data, size_t len) {
+    maus_bus_segment_t segment = { .data = data, .len = len };
+    return _sim_readv(address, subaddress, &segment, 1);
+}
+
+static maus_bus_err_t _sim_probe(uint8_t address) {
+    maus_bus_sim_msg_t msg = {
+        .op = MAUS_BUS_SIM_OP_PROBE,
+        .address = address,
+        .subaddress = 0,
+        .status = 0,
+        .len = 0,
+    };
+
+    return _transact(&msg, NULL, 0, NULL, 0);
+}
+
+maus_bus_err_t maus_bus_sim_connect(const char* path, maus_bus_config_t* config) {
+    struct sockaddr_un addr;
+
+    if (config == NULL) return MAUS_BUS_FAIL;
+    if (path == NULL) path = MAUS_BUS_SIM_DEFAULT_PATH;
+
+    maus_bus_sim_disconnect();
+
+    _fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_fd < 0) return MAUS_BUS_FAIL;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    if (connect(_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        maus_bus_sim_disconnect();
+        return MAUS_BUS_FAIL;
+    }
+
+    memset(config, 0, sizeof(*config));
+    config->read = &_sim_read;
+    config->write = &_sim_write;
+    config->probe = &_sim_probe;
+    config->writev = &_sim_writev;
+    config->readv = &_sim_readv;
+
+    return MAUS_BUS_OK;
+}
+
+void maus_bus_sim_disconnect(void) {
+    if (_fd >= 0) close(_fd);
+    _fd = -1;
+}
+
+maus_bus_err_t maus_bus_sim_hotplug(uint8_t address, int attached) {
+    maus_bus_sim_msg_t msg = {
+        .op = MAUS_BUS_SIM_OP_HOTPLUG,
+        .address = address,
+        .subaddress = attached ? 1 : 0,
+        .status = 0,
+        .len = 0,
+    };
+
+    return _transact(&msg, NULL, 0, NULL, 0);
+}
+
+maus_bus_err_t maus_bus_sim_set_latency(uint32_t latency_us) {
+    maus_bus_segment_t segment = { .data = (uint8_t*)&latency_us, .len = sizeof(latency_us) };
+    maus_bus_sim_msg_t msg = {
+        .op = MAUS_BUS_SIM_OP_LATENCY,
+        .address = 0,
+        .subaddress = 0,
+        .status = 0,
+        .len = sizeof(latency_us),
+    };
+
+    return _transact(&msg, &segment, 1, NULL, 0);
+}
+
+maus_bus_err_t maus_bus_sim_get_stats(maus_bus_sim_stats_t* stats) {
+    maus_bus_segment_t segment = { .data = (uint8_t*)stats, .len = sizeof(*stats) };
+    maus_bus_sim_msg_t msg = {
+        .op = MAUS_BUS_SIM_OP_STATS,
+        .address = 0,
+        .subaddress = 0,
+        .status = 0,
+        .len = 0,
+    };
+
+    return _transact(&msg, NULL, 0, &segment, 1);
+}
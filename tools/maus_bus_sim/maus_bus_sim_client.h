@@ -0,0 +1,46 @@
+#ifndef __maus_bus_sim__maus_bus_sim_client_h
+#define __maus_bus_sim__maus_bus_sim_client_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "maus_bus.h"
+#include "maus_bus_sim_proto.h"
+
+/**
+ * @brief Connects to a running maus_bus_simd and fills in a config that talks to it.
+ *
+ * Pass the config on to maus_bus_init as usual. One connection is kept per process, and like the
+ * rest of the library it is not thread-safe.
+ *
+ * @param path Socket path, or NULL for MAUS_BUS_SIM_DEFAULT_PATH.
+ * @param config
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_sim_connect(const char* path, maus_bus_config_t* config);
+void maus_bus_sim_disconnect(void);
+
+/**
+ * @brief Attaches or detaches a simulated device, as if it were plugged in or pulled out.
+ *
+ * @param address
+ * @param attached
+ * @return maus_bus_err_t MAUS_BUS_NOT_SUPPORTED if nothing is simulated at that address.
+ */
+maus_bus_err_t maus_bus_sim_hotplug(uint8_t address, int attached);
+
+/**
+ * @brief Adds latency to every transaction on the simulated bus, for every client.
+ *
+ * @param latency_us
+ * @return maus_bus_err_t
+ */
+maus_bus_err_t maus_bus_sim_set_latency(uint32_t latency_us);
+maus_bus_err_t maus_bus_sim_get_stats(maus_bus_sim_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
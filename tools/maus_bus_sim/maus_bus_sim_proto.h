@@ -0,0 +1,57 @@
+#ifndef __maus_bus_sim__maus_bus_sim_proto_h
+#define __maus_bus_sim__maus_bus_sim_proto_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define MAUS_BUS_SIM_DEFAULT_PATH "/tmp/maus_bus_sim.sock"
+#define MAUS_BUS_SIM_MAX_PAYLOAD 1024
+
+/**
+ * @brief Operations understood by the simulator. Every request gets exactly one reply with the
+ * same op, and the result in status.
+ */
+typedef enum {
+    MAUS_BUS_SIM_OP_READ = 0x01,    // len = bytes requested, reply carries the data.
+    MAUS_BUS_SIM_OP_WRITE = 0x02,   // Payload is the data to write.
+    MAUS_BUS_SIM_OP_PROBE = 0x03,   // Address only.
+    MAUS_BUS_SIM_OP_HOTPLUG = 0x10, // subaddress is 1 to attach, 0 to detach the device at address.
+    MAUS_BUS_SIM_OP_LATENCY = 0x11, // Payload is a uint32_t of extra microseconds per transaction.
+    MAUS_BUS_SIM_OP_STATS = 0x12,   // Reply payload is a maus_bus_sim_stats_t.
+} maus_bus_sim_op_t;
+
+/**
+ * @brief Message header. Requests and replies both use this, followed by len bytes of payload.
+ *
+ * The wire format is host-endian, since the simulator and its clients always share one machine.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t op;
+    uint8_t address;
+    uint8_t subaddress;
+    uint8_t status; // maus_bus_err_t in replies, 0 in requests.
+    uint16_t len;
+} maus_bus_sim_msg_t;
+
+/**
+ * @brief Bus-wide counters, returned by MAUS_BUS_SIM_OP_STATS.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t transactions;     // Read, write and probe requests served.
+    uint32_t failures;         // Requests that were NACKed (no device, detached, bad register).
+    uint32_t bytes;            // Payload bytes moved in either direction.
+    uint64_t busy_us;          // Simulated time the bus was occupied.
+    uint32_t clients;          // Clients currently connected.
+    uint32_t max_contention;   // Most clients seen waiting on the bus in one arbitration round.
+    uint32_t hotplug_events;   // Attach and detach requests applied.
+    uint32_t rx_overruns;      // Bytes dropped because a simulated UART RX FIFO was full.
+} maus_bus_sim_stats_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
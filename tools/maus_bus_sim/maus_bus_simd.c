@@ -0,0 +1,678 @@
+/**
+ * Maus-Bus simulator daemon.
+ *
+ * Owns one virtual bus and serves read/write/probe requests from any number of controller
+ * processes over a UNIX socket. Requests are served one at a time, round-robin across clients, so
+ * the bus is arbitrated the same way a shared I2C master would be.
+ *
+ * Build:
+ *   gcc -Iinclude -Itools/maus_bus_sim tools/maus_bus_sim/maus_bus_simd.c -o maus_bus_simd
+ *
+ * Usage:
+ *   maus_bus_simd [-s path] [-k bus_hz] [-l latency_us] [-e addr[:feature...]] [-u] [-p script]
+ *                 [-g addr] [-t]
+ *
+ *   -s path    Socket path, default /tmp/maus_bus_sim.sock
+ *   -k bus_hz  Simulated bus clock used to charge on-wire time, default 100000. 0 disables it.
+ *   -l us      Extra latency per transaction, in microseconds.
+ *   -e addr    EEPROM ID chip at addr. Features may follow: serial, gpio, tscode.
+ *   -u         SC16IS740 UART at 0x4D, looped back to itself. The register banks selected by
+ *              LCR[7], LCR = 0xBF and MCR[2] are modelled, so flow control and baud setup land
+ *              where they would on the chip.
+ *   -p script  SC16IS740 UART at 0x4D with a scripted peer instead of loopback. Each line of the
+ *              script is a reply in hex bytes, queued into the RX FIFO after each transmit. A
+ *              transmit is every THR write up to the next access to any register but THR and
+ *              TXLVL, so it doesn't matter how many chunks the host split it into.
+ *   -g addr    PCA9554 GPIO expander at addr.
+ *   -t         TS-Code listener at 0x69.
+ *
+ * Hubs are not simulated yet, the library does not walk them either.
+ */
+
+// usleep, strtok_r and getopt are POSIX, not C11.
+#define _DEFAULT_SOURCE
+
+#include "maus_bus.h"
+#include "maus_bus_sim_proto.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "drivers/pca9554.h"
+#include "drivers/sc16is740.h"
+
+#define SIM_MAX_CLIENTS 64
+#define SIM_MAX_SCRIPT_LINES 256
+#define SIM_FIFO_SIZE 64
+#define SIM_EEPROM_SIZE 256
+
+typedef enum {
+    SIM_DEVICE_NONE,
+    SIM_DEVICE_EEPROM,
+    SIM_DEVICE_SC16,
+    SIM_DEVICE_PCA9554,
+    SIM_DEVICE_TSCODE,
+} sim_device_type_t;
+
+typedef struct {
+    sim_device_type_t type;
+    int attached;
+
+    union {
+        struct {
+            uint8_t mem[SIM_EEPROM_SIZE];
+        } eeprom;
+
+        struct {
+            uint8_t regs[16];    // General register set.
+            uint8_t divisor[2];  // DLL and DLH, while LCR[7] is set.
+            uint8_t enhanced[8]; // EFR and XON1 to XOFF2 at their offsets, while LCR is 0xBF.
+            uint8_t tcr;         // In place of MSR and SPR while MCR[2] and EFR[4] are set.
+            uint8_t tlr;
+            uint8_t fcr; // Write-only, IIR reads at the same offset.
+            uint8_t rx_fifo[SIM_FIFO_SIZE];
+            size_t rx_head;
+            size_t rx_count;
+            int transmitting; // THR written, and the scripted peer hasn't replied yet.
+        } sc16;
+
+        struct {
+            uint8_t regs[4];
+        } pca9554;
+
+        struct {
+            uint8_t last_subaddress;
+            uint32_t commands;
+        } tscode;
+    };
+} sim_device_t;
+
+static sim_device_t _bus[128];
+
+static struct {
+    uint8_t data[SIM_FIFO_SIZE];
+    size_t len;
+} _script[SIM_MAX_SCRIPT_LINES];
+
+static size_t _script_len = 0;
+static size_t _script_pos = 0;
+
+static uint32_t _bus_hz = 100000;
+static uint32_t _latency_us = 0;
+static maus_bus_sim_stats_t _stats;
+static volatile sig_atomic_t _running = 1;
+
+// Virtual Devices
+
+static void _sc16_push_rx(sim_device_t* dev, uint8_t byte) {
+    if (dev->sc16.rx_count >= SIM_FIFO_SIZE) {
+        dev->sc16.regs[SC16_REG_LSR] |= 0x02; // Overrun error
+        _stats.rx_overruns++;
+        return;
+    }
+
+    dev->sc16.rx_fifo[(dev->sc16.rx_head + dev->sc16.rx_count) % SIM_FIFO_SIZE] = byte;
+    dev->sc16.rx_count++;
+}
+
+/**
+ * @brief Queues the scripted reply once the host is done transmitting.
+ */
+static void _sc16_end_transmit(sim_device_t* dev) {
+    if (!dev->sc16.transmitting) return;
+    dev->sc16.transmitting = 0;
+
+    if (_script_pos < _script_len) {
+        for (size_t i = 0; i < _script[_script_pos].len; i++)
+            _sc16_push_rx(dev, _script[_script_pos].data[i]);
+        _script_pos++;
+    }
+}
+
+static int _sc16_efr_enabled(const sim_device_t* dev) {
+    return (dev->sc16.enhanced[SC16_REG_EFR] & 0x10) != 0;
+}
+
+/**
+ * @brief The register an offset reaches outside the general set, given the current LCR, MCR and
+ * EFR, or NULL if it reaches the general set.
+ */
+static uint8_t* _sc16_banked(sim_device_t* dev, uint8_t reg) {
+    uint8_t lcr = dev->sc16.regs[SC16_REG_LCR];
+
+    if (lcr == SC16_LCR_ENHANCED &&
+        (reg == SC16_REG_EFR || (reg >= SC16_REG_XON1 && reg <= SC16_REG_XOFF2))) {
+        return &dev->sc16.enhanced[reg];
+    }
+
+    // 0xBF has LCR[7] set too, so the divisor latch stays reachable in the enhanced set.
+    if ((lcr & 0x80) && (reg == SC16_REG_DLL || reg == SC16_REG_DLH)) {
+        return &dev->sc16.divisor[reg];
+    }
+
+    if (_sc16_efr_enabled(dev) && (dev->sc16.regs[SC16_REG_MCR] & 0x04)) {
+        if (reg == SC16_REG_TCR) return &dev->sc16.tcr;
+        if (reg == SC16_REG_TLR) return &dev->sc16.tlr;
+    }
+
+    return NULL;
+}
+
+static uint8_t _sc16_read_reg(sim_device_t* dev, uint8_t reg) {
+    uint8_t* banked = _sc16_banked(dev, reg);
+
+    // Polling TXLVL between chunks is still part of the transmit.
+    if (banked != NULL || reg != SC16_REG_TXLVL) _sc16_end_transmit(dev);
+    if (banked != NULL) return *banked;
+
+    switch (reg) {
+    case SC16_REG_RHR: {
+        if (dev->sc16.rx_count == 0) return 0x00;
+        uint8_t byte = dev->sc16.rx_fifo[dev->sc16.rx_head];
+        dev->sc16.rx_head = (dev->sc16.rx_head + 1) % SIM_FIFO_SIZE;
+        dev->sc16.rx_count--;
+        return byte;
+    }
+
+    case SC16_REG_IIR:
+        // No interrupt pending, FIFOs reported enabled when FCR[0] is.
+        return (dev->sc16.fcr & 0x01 ? 0xC0 : 0x00) | 0x01;
+
+    case SC16_REG_LSR: {
+        uint8_t lsr = dev->sc16.regs[SC16_REG_LSR] | 0x60; // THR and TSR always empty
+        if (dev->sc16.rx_count > 0) lsr |= 0x01;
+        dev->sc16.regs[SC16_REG_LSR] &= ~0x02; // Overrun clears on read
+        return lsr;
+    }
+
+    case SC16_REG_TXLVL:
+        return SIM_FIFO_SIZE;
+
+    case SC16_REG_RXLVL:
+        return (uint8_t)dev->sc16.rx_count;
+
+    default:
+        return dev->sc16.regs[reg & 0x0F];
+    }
+}
+
+/**
+ * @brief Writes one of the general registers other than THR.
+ */
+static void _sc16_write_reg(sim_device_t* dev, uint8_t reg, uint8_t value) {
+    switch (reg) {
+    case SC16_REG_FCR:
+        // FCR[1] resets the RX FIFO and clears itself. There is no TX FIFO to reset.
+        if (value & 0x02) {
+            dev->sc16.rx_head = 0;
+            dev->sc16.rx_count = 0;
+        }
+        dev->sc16.fcr = value & ~0x06;
+        return;
+
+    case SC16_REG_IER:
+        // IER[7:4] are enhanced features, only writable with EFR[4] set.
+        if (!_sc16_efr_enabled(dev)) value = (value & 0x0F) | (dev->sc16.regs[reg] & 0xF0);
+        break;
+
+    case SC16_REG_MCR:
+        // Likewise MCR[7:5], which includes the clock prescaler.
+        if (!_sc16_efr_enabled(dev)) value = (value & 0x1F) | (dev->sc16.regs[reg] & 0xE0);
+        break;
+
+    case SC16_REG_LSR:
+    case SC16_REG_MSR:
+    case SC16_REG_TXLVL:
+    case SC16_REG_RXLVL:
+        return; // Read-only
+
+    default:
+        break;
+    }
+
+    dev->sc16.regs[reg & 0x0F] = value;
+}
+
+static void _sc16_write(sim_device_t* dev, uint8_t reg, const uint8_t* data, size_t len) {
+    uint8_t* banked = _sc16_banked(dev, reg);
+
+    if (banked != NULL || reg != SC16_REG_THR) _sc16_end_transmit(dev);
+
+    // Everything but THR is a single register, so repeated bytes land on the same one.
+    if (banked != NULL) {
+        if (len > 0) *banked = data[len - 1];
+        return;
+    }
+
+    if (reg != SC16_REG_THR) {
+        if (len > 0) _sc16_write_reg(dev, reg, data[len - 1]);
+        return;
+    }
+
+    if (_script_len == 0) {
+        for (size_t i = 0; i < len; i++)
+            _sc16_push_rx(dev, data[i]);
+        return;
+    }
+
+    dev->sc16.transmitting = 1;
+}
+
+static maus_bus_err_t
+_device_read(sim_device_t* dev, uint8_t subaddress, uint8_t* data, size_t len) {
+    switch (dev->type) {
+    case SIM_DEVICE_EEPROM:
+        for (size_t i = 0; i < len; i++)
+            data[i] = dev->eeprom.mem[(subaddress + i) % SIM_EEPROM_SIZE];
+        return MAUS_BUS_OK;
+
+    case SIM_DEVICE_SC16:
+        for (size_t i = 0; i < len; i++)
+            data[i] = _sc16_read_reg(dev, (subaddress >> 3) & 0x0F);
+        return MAUS_BUS_OK;
+
+    case SIM_DEVICE_PCA9554: {
+        if (subaddress > PCA9554_REG_CONFIG) return MAUS_BUS_FAIL;
+        uint8_t* regs = dev->pca9554.regs;
+
+        // Pins configured as outputs read back their output level, inputs float high.
+        regs[PCA9554_REG_INPUT] =
+            (regs[PCA9554_REG_OUTPUT] & ~regs[PCA9554_REG_CONFIG]) | regs[PCA9554_REG_CONFIG];
+        regs[PCA9554_REG_INPUT] ^= regs[PCA9554_REG_POLARITY];
+
+        for (size_t i = 0; i < len; i++)
+            data[i] = regs[subaddress];
+        return MAUS_BUS_OK;
+    }
+
+    case SIM_DEVICE_TSCODE:
+        memset(data, 0, len);
+        return MAUS_BUS_OK;
+
+    default:
+        return MAUS_BUS_FAIL;
+    }
+}
+
+static maus_bus_err_t
+_device_write(sim_device_t* dev, uint8_t subaddress, const uint8_t* data, size_t len) {
+    switch (dev->type) {
+    case SIM_DEVICE_EEPROM:
+        for (size_t i = 0; i < len; i++)
+            dev->eeprom.mem[(subaddress + i) % SIM_EEPROM_SIZE] = data[i];
+        return MAUS_BUS_OK;
+
+    case SIM_DEVICE_SC16:
+        _sc16_write(dev, (subaddress >> 3) & 0x0F, data, len);
+        return MAUS_BUS_OK;
+
+    case SIM_DEVICE_PCA9554:
+        if (subaddress > PCA9554_REG_CONFIG || subaddress == PCA9554_REG_INPUT)
+            return MAUS_BUS_FAIL;
+        if (len > 0) dev->pca9554.regs[subaddress] = data[len - 1];
+        return MAUS_BUS_OK;
+
+    case SIM_DEVICE_TSCODE:
+        dev->tscode.last_subaddress = subaddress;
+        dev->tscode.commands++;
+        return MAUS_BUS_OK;
+
+    default:
+        return MAUS_BUS_FAIL;
+    }
+}
+
+// Bus Timing
+
+static void _occupy_bus(size_t bytes) {
+    uint64_t us = _latency_us;
+
+    // Address + subaddress + data, 9 clocks per byte including ACK.
+    if (_bus_hz > 0) us += ((uint64_t)(bytes + 2) * 9 * 1000000) / _bus_hz;
+
+    _stats.busy_us += us;
+    if (us > 0) usleep((useconds_t)us);
+}
+
+// Topology
+
+static int _parse_address(const char* str, uint8_t* address) {
+    char* end = NULL;
+    long value = strtol(str, &end, 0);
+    if (end == str || value < 0 || value > 0x7F) return -1;
+    *address = (uint8_t)value;
+    return 0;
+}
+
+static int _add_eeprom(char* spec) {
+    char* saveptr = NULL;
+    char* token = strtok_r(spec, ":", &saveptr);
+    uint8_t address = 0;
+
+    if (token == NULL || _parse_address(token, &address) != 0) return -1;
+
+    maus_bus_device_t record;
+    memset(&record, 0, sizeof(record));
+    record.__guard = 0xCAFE;
+    record.vendor_id = 0xFFFF;
+    record.product_id = address;
+
+    while ((token = strtok_r(NULL, ":", &saveptr)) != NULL) {
+        if (strcmp(token, "serial") == 0) {
+            record.features.serial = 1;
+        } else if (strcmp(token, "gpio") == 0) {
+            record.features.gpio = 1;
+        } else if (strcmp(token, "tscode") == 0) {
+            record.features.tscode = 1;
+        } else {
+            return -1;
+        }
+    }
+
+    snprintf(record.vendor_name, sizeof(record.vendor_name), "Maus-Bus Simulator");
+    snprintf(record.product_name, sizeof(record.product_name), "Sim 0x%02X", address);
+
+    _bus[address].type = SIM_DEVICE_EEPROM;
+    _bus[address].attached = 1;
+    memcpy(_bus[address].eeprom.mem, &record, sizeof(record));
+    return 0;
+}
+
+static int _load_script(const char* path) {
+    FILE* f = fopen(path, "r");
+    char line[512];
+
+    if (f == NULL) return -1;
+
+    while (fgets(line, sizeof(line), f) != NULL && _script_len < SIM_MAX_SCRIPT_LINES) {
+        char* cursor = line;
+        char* end = NULL;
+
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        _script[_script_len].len = 0;
+
+        while (_script[_script_len].len < SIM_FIFO_SIZE) {
+            long byte = strtol(cursor, &end, 16);
+            if (end == cursor) break;
+            _script[_script_len].data[_script[_script_len].len++] = (uint8_t)byte;
+            cursor = end;
+        }
+
+        _script_len++;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+// Protocol
+
+static int _read_full(int fd, void* buf, size_t len) {
+    uint8_t* p = (uint8_t*)buf;
+
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+static int _write_full(int fd, const void* buf, size_t len) {
+    const uint8_t* p = (const uint8_t*)buf;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= (size_t)n;
+    }
+
+    return 0;
+}
+
+static int _reply(int fd, maus_bus_sim_msg_t* msg, maus_bus_err_t status, const void* payload) {
+    msg->status = (uint8_t)status;
+    if (_write_full(fd, msg, sizeof(*msg)) != 0) return -1;
+    if (msg->len > 0 && _write_full(fd, payload, msg->len) != 0) return -1;
+    return 0;
+}
+
+/**
+ * @brief Serves exactly one request from a client. Returns -1 if the client should be dropped.
+ */
+static int _serve(int fd) {
+    maus_bus_sim_msg_t msg;
+    uint8_t payload[MAUS_BUS_SIM_MAX_PAYLOAD];
+    maus_bus_err_t err = MAUS_BUS_OK;
+
+    if (_read_full(fd, &msg, sizeof(msg)) != 0) return -1;
+    if (msg.len > MAUS_BUS_SIM_MAX_PAYLOAD) return -1;
+    if (msg.address > 0x7F) return -1;
+
+    sim_device_t* dev = &_bus[msg.address];
+    int present = dev->type != SIM_DEVICE_NONE && dev->attached;
+
+    switch (msg.op) {
+    case MAUS_BUS_SIM_OP_READ:
+        _stats.transactions++;
+        _occupy_bus(msg.len);
+        err = present ? _device_read(dev, msg.subaddress, payload, msg.len) : MAUS_BUS_FAIL;
+        if (err != MAUS_BUS_OK) {
+            _stats.failures++;
+            memset(payload, 0, msg.len);
+        } else {
+            _stats.bytes += msg.len;
+        }
+        return _reply(fd, &msg, err, payload);
+
+    case MAUS_BUS_SIM_OP_WRITE:
+        if (_read_full(fd, payload, msg.len) != 0) return -1;
+        _stats.transactions++;
+        _occupy_bus(msg.len);
+        err = present ? _device_write(dev, msg.subaddress, payload, msg.len) : MAUS_BUS_FAIL;
+        if (err != MAUS_BUS_OK) {
+            _stats.failures++;
+        } else {
+            _stats.bytes += msg.len;
+        }
+        msg.len = 0;
+        return _reply(fd, &msg, err, NULL);
+
+    case MAUS_BUS_SIM_OP_PROBE:
+        _stats.transactions++;
+        _occupy_bus(0);
+        err = present ? MAUS_BUS_OK : MAUS_BUS_FAIL;
+        if (err != MAUS_BUS_OK) _stats.failures++;
+        return _reply(fd, &msg, err, NULL);
+
+    case MAUS_BUS_SIM_OP_HOTPLUG:
+        if (dev->type == SIM_DEVICE_NONE) {
+            err = MAUS_BUS_NOT_SUPPORTED;
+        } else {
+            dev->attached = msg.subaddress != 0;
+            _stats.hotplug_events++;
+        }
+        return _reply(fd, &msg, err, NULL);
+
+    case MAUS_BUS_SIM_OP_LATENCY:
+        if (msg.len != sizeof(uint32_t)) return -1;
+        if (_read_full(fd, &_latency_us, sizeof(uint32_t)) != 0) return -1;
+        msg.len = 0;
+        return _reply(fd, &msg, MAUS_BUS_OK, NULL);
+
+    case MAUS_BUS_SIM_OP_STATS:
+        msg.len = sizeof(_stats);
+        return _reply(fd, &msg, MAUS_BUS_OK, &_stats);
+
+    default:
+        // Unknown op, but the payload still has to be drained to stay in sync.
+        if (_read_full(fd, payload, msg.len) != 0) return -1;
+        msg.len = 0;
+        return _reply(fd, &msg, MAUS_BUS_NOT_SUPPORTED, NULL);
+    }
+}
+
+static void _on_signal(int sig) {
+    (void)sig;
+    _running = 0;
+}
+
+static void _usage(const char* argv0) {
+    fprintf(
+        stderr,
+        "usage: %s [-s path] [-k bus_hz] [-l latency_us] [-e addr[:feature...]] [-u] [-p script] "
+        "[-g addr] [-t]\n",
+        argv0
+    );
+}
+
+int main(int argc, char** argv) {
+    const char* path = MAUS_BUS_SIM_DEFAULT_PATH;
+    uint8_t address = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:k:l:e:up:g:th")) != -1) {
+        switch (opt) {
+        case 's':
+            path = optarg;
+            break;
+        case 'k':
+            _bus_hz = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            _latency_us = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'e':
+            if (_add_eeprom(optarg) != 0) {
+                fprintf(stderr, "bad EEPROM spec: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'p':
+            if (_load_script(optarg) != 0) {
+                fprintf(stderr, "can't read script: %s\n", optarg);
+                return 1;
+            }
+            // fall through
+        case 'u':
+            _bus[SC16_ADDRESS].type = SIM_DEVICE_SC16;
+            _bus[SC16_ADDRESS].attached = 1;
+            break;
+        case 'g':
+            if (_parse_address(optarg, &address) != 0) {
+                fprintf(stderr, "bad address: %s\n", optarg);
+                return 1;
+            }
+            _bus[address].type = SIM_DEVICE_PCA9554;
+            _bus[address].attached = 1;
+            _bus[address].pca9554.regs[PCA9554_REG_OUTPUT] = 0xFF;
+            _bus[address].pca9554.regs[PCA9554_REG_CONFIG] = 0xFF;
+            break;
+        case 't':
+            _bus[0x69].type = SIM_DEVICE_TSCODE;
+            _bus[0x69].attached = 1;
+            break;
+        default:
+            _usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    unlink(path);
+
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 16) != 0) {
+        perror(path);
+        return 1;
+    }
+
+    signal(SIGINT, _on_signal);
+    signal(SIGTERM, _on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    struct pollfd fds[SIM_MAX_CLIENTS + 1];
+    size_t client_count = 0;
+    size_t next_client = 0;
+
+    fds[0].fd = listen_fd;
+    fds[0].events = POLLIN;
+
+    while (_running) {
+        if (poll(fds, client_count + 1, 1000) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+
+            if (fd >= 0 && client_count < SIM_MAX_CLIENTS) {
+                fds[client_count + 1].fd = fd;
+                fds[client_count + 1].events = POLLIN;
+                fds[client_count + 1].revents = 0;
+                client_count++;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        // Everyone with a pending request is contending for the bus this round.
+        uint32_t waiting = 0;
+        for (size_t i = 1; i <= client_count; i++) {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) waiting++;
+        }
+        if (waiting > _stats.max_contention) _stats.max_contention = waiting;
+
+        // Round-robin, starting after whoever went first last time, one request per client.
+        for (size_t n = 0; n < client_count; n++) {
+            size_t i = 1 + (next_client + n) % client_count;
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            fds[i].revents = 0;
+            if (_serve(fds[i].fd) != 0) {
+                close(fds[i].fd);
+                fds[i].fd = -1;
+            }
+        }
+
+        if (client_count > 0) next_client = (next_client + 1) % client_count;
+
+        // Compact out any dropped clients.
+        size_t kept = 0;
+        for (size_t i = 1; i <= client_count; i++) {
+            if (fds[i].fd >= 0) fds[++kept] = fds[i];
+        }
+        client_count = kept;
+        _stats.clients = (uint32_t)client_count;
+    }
+
+    for (size_t i = 1; i <= client_count; i++)
+        close(fds[i].fd);
+
+    close(listen_fd);
+    unlink(path);
+    return 0;
+}